@@ -0,0 +1,115 @@
+/*
+ *  CSCI-3753 Design and Analysis of Operating Systems PA3 Bounded Buffer problem - affinity definition.
+ */
+
+#include "affinity.h"
+
+#define NODE_PATH_LENGTH 64
+#define CPU_LIST_LENGTH 4096
+
+// Parse a CPU list as it is written, without checking that the CPUs in it can be used.
+static int parse_cpu_ranges(const char* list, cpu_set_t* set){
+  CPU_ZERO(set);
+  const char* p = list;
+
+  while(*p != '\0' && *p != '\n'){
+    char* end;
+    long first = strtol(p, &end, 10);
+    long last = first;
+
+    // Every entry must start with a CPU number.
+    if(end == p || first < 0){
+      return -1;
+    }
+    p = end;
+
+    // An entry may be a range of CPUs, "first-last".
+    if(*p == '-'){
+      p++;
+      last = strtol(p, &end, 10);
+      if(end == p || last < first){
+	return -1;
+      }
+      p = end;
+    }
+
+    if(last >= CPU_SETSIZE){
+      return -1;
+    }
+    for(long cpu = first; cpu <= last; cpu++){
+      CPU_SET(cpu, set);
+    }
+
+    // Entries are separated by commas.
+    if(*p == ','){
+      p++;
+    }else if(*p != '\0' && *p != '\n'){
+      return -1;
+    }
+  }
+
+  return CPU_COUNT(set) > 0 ? 0 : -1;
+}
+
+// Read the list of CPUs that belong to a NUMA node out of sysfs.
+static int read_node_list(int node, char* list, int length){
+  char path[NODE_PATH_LENGTH];
+
+  snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+  FILE* fd = fopen(path, "r");
+  if(fd == NULL){
+    return -1;
+  }
+
+  char* read = fgets(list, length, fd);
+  fclose(fd);
+  return read == NULL ? -1 : 0;
+}
+
+// Definition of parse_cpu_list method.
+int parse_cpu_list(const char* list, cpu_set_t* set){
+  cpu_set_t allowed;
+
+  if(parse_cpu_ranges(list, set) != 0){
+    return -1;
+  }
+
+  // Only keep the CPUs we may actually run on.  A thread pinned to nothing but offline or forbidden CPUs can't be created.
+  if(sched_getaffinity(0, sizeof(allowed), &allowed) != 0){
+    return -1;
+  }
+  CPU_AND(set, set, &allowed);
+  return CPU_COUNT(set) > 0 ? 0 : -1;
+}
+
+// Definition of numa_node_cpus method.
+int numa_node_cpus(int node, cpu_set_t* set){
+  char list[CPU_LIST_LENGTH];
+
+  if(read_node_list(node, list, sizeof(list)) != 0){
+    return -1;
+  }
+  return parse_cpu_list(list, set);
+}
+
+// Definition of numa_current_node method.
+int numa_current_node(){
+  int cpu = sched_getcpu();
+  cpu_set_t set;
+
+  char list[CPU_LIST_LENGTH];
+
+  // Walk the nodes until we find the one that owns our CPU, stopping at the first node that doesn't exist.
+  for(int node = 0; cpu >= 0 && read_node_list(node, list, sizeof(list)) == 0; node++){
+    if(parse_cpu_ranges(list, &set) == 0 && CPU_ISSET(cpu, &set)){
+      return node;
+    }
+  }
+
+  return 0;
+}
+
+// Definition of pin_current_thread method.
+int pin_current_thread(cpu_set_t* set){
+  return pthread_setaffinity_np(pthread_self(), sizeof(*set), set);
+}
@@ -0,0 +1,54 @@
+/*
+ *  CSCI-3753 Design and Analysis of Operating Systems, PA3 Bounded Buffer Problem - affinity header file.
+ *
+ *  Helpers for pinning requester/resolver threads to a set of CPUs.  CPU sets are given by the user in the
+ *  same "0-3,8,10-11" list format the kernel uses in sysfs, and NUMA topology is read straight out of
+ *  /sys/devices/system/node so that no extra libraries are needed to find out which CPUs share a node.
+ */
+
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <sched.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ *  Prototype of parse_cpu_list method.
+ *  This method parses a CPU list such as "0-3,8,10-11" into a cpu_set_t, keeping only the CPUs this process is
+ *  allowed to run on (sched_getaffinity), so offline CPUs are dropped.
+ *  Params:  the list string, the set to be filled in (it is cleared first).
+ *  Returns 0 on success, -1 if the list is malformed, names a CPU beyond CPU_SETSIZE or has no usable CPU in it.
+ */
+int parse_cpu_list(const char* list, cpu_set_t* set);
+
+/*
+ *  Prototype of numa_current_node method.
+ *  This method finds the NUMA node of the CPU the calling thread is currently running on.
+ *  Returns the node number, or 0 if the machine exposes no NUMA information.
+ */
+int numa_current_node();
+
+/*
+ *  Prototype of numa_node_cpus method.
+ *  This method fills in the set of CPUs that belong to the given NUMA node and that this process may run on.
+ *  Params:  the node number, the set to be filled in.
+ *  Returns 0 on success, -1 if the node does not exist or none of its CPUs can be used.
+ */
+int numa_node_cpus(int node, cpu_set_t* set);
+
+/*
+ *  Prototype of pin_current_thread method.
+ *  This method restricts the calling thread to the given CPUs.  Memory the thread touches for the first time
+ *  afterwards is placed on the NUMA node of those CPUs by the kernel's default first-touch policy.
+ *  Params:  the set of CPUs to run on.
+ *  Returns 0 on success, nonzero on failure.
+ */
+int pin_current_thread(cpu_set_t* set);
+
+#endif
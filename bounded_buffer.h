@@ -0,0 +1,166 @@
+/*
+ *  CSCI-3753 Design and Analysis of Operating Systems, PA3 Bounded Buffer Problem - generic bounded buffer header file.
+ *
+ *  DEFINE_BOUNDED_BUFFER(Name, T, N) generates a thread-safe FIFO queue type called Name holding up to N elements of
+ *  type T, and the methods that go with it, each prefixed with Name_.  The element type and capacity are fixed at
+ *  compile time, so the slots are stored inline in the struct and the struct can be placed anywhere: on the heap, in
+ *  an anonymous mapping, or in POSIX shared memory for use across processes.  When N is a power of two, slots are
+ *  indexed with a mask instead of a division.
+ *
+ *  Elements are moved in and out with a single struct assignment and never copied anywhere else.  The queue doesn't
+ *  look inside them, so any pointers they hold simply change hands along with them; a slot that has been read is left
+ *  as it is until it is written over.
+ *
+ *  head and tail only ever increase; the number of stored elements is their difference, so a process that dies part
+ *  way through a get or put can never leave the count and the slots disagreeing with each other.
+ */
+
+#ifndef BOUNDED_BUFFER_H
+#define BOUNDED_BUFFER_H
+
+#include <pthread.h>
+#include <errno.h>
+
+// The slot an ever-increasing counter maps to.  N is a constant, so the test is folded away at compile time.
+#define BOUNDED_BUFFER_SLOT(i, N) ((((N) & ((N) - 1)) == 0) ? ((i) & ((N) - 1)) : ((i) % (N)))
+
+#define DEFINE_BOUNDED_BUFFER(Name, T, N)                                                                              \
+                                                                                                                       \
+typedef struct Name{                                                                                                   \
+  pthread_mutex_t mutex;                                                                                               \
+  pthread_cond_t readBlock;                                                                                            \
+  pthread_cond_t writeBlock;                                                                                           \
+  unsigned long head;                                                                                                  \
+  unsigned long tail;                                                                                                  \
+  int closed;                                                                                                          \
+  T slots[N];                                                                                                          \
+} Name;                                                                                                                \
+                                                                                                                       \
+/* Initialize an empty buffer.  If shared, its primitives are process-shared and the mutex is robust. */               \
+static inline int Name##_init(Name* buffer, int shared)                                                                \
+{                                                                                                                      \
+  pthread_mutexattr_t mattr;                                                                                           \
+  pthread_condattr_t cattr;                                                                                            \
+  int err;                                                                                                             \
+                                                                                                                       \
+  buffer->head = 0;                                                                                                    \
+  buffer->tail = 0;                                                                                                    \
+  buffer->closed = 0;                                                                                                  \
+  pthread_mutexattr_init(&mattr);                                                                                      \
+  pthread_condattr_init(&cattr);                                                                                       \
+  if(shared){                                                                                                          \
+    pthread_mutexattr_setpshared(&mattr, PTHREAD_PROCESS_SHARED);                                                      \
+    pthread_mutexattr_setrobust(&mattr, PTHREAD_MUTEX_ROBUST);                                                         \
+    pthread_condattr_setpshared(&cattr, PTHREAD_PROCESS_SHARED);                                                       \
+  }                                                                                                                    \
+                                                                                                                       \
+  err = pthread_mutex_init(&buffer->mutex, &mattr);                                                                    \
+  if(err == 0){                                                                                                        \
+    err = pthread_cond_init(&buffer->readBlock, &cattr);                                                               \
+  }                                                                                                                    \
+  if(err == 0){                                                                                                        \
+    err = pthread_cond_init(&buffer->writeBlock, &cattr);                                                              \
+  }                                                                                                                    \
+                                                                                                                       \
+  pthread_mutexattr_destroy(&mattr);                                                                                   \
+  pthread_condattr_destroy(&cattr);                                                                                    \
+  return err;                                                                                                          \
+}                                                                                                                      \
+                                                                                                                       \
+/* Recover the mutex if the process holding it died.  head and tail are only changed by single stores. */              \
+static inline void Name##_recover(Name* buffer, int err)                                                               \
+{                                                                                                                      \
+  if(err == EOWNERDEAD){                                                                                               \
+    pthread_mutex_consistent(&buffer->mutex);                                                                          \
+  }                                                                                                                    \
+}                                                                                                                      \
+                                                                                                                       \
+/* Move an element in, blocking while the buffer is full.  Returns 0 on success. */                                    \
+static inline int Name##_put(Name* buffer, T* element)                                                                 \
+{                                                                                                                      \
+  Name##_recover(buffer, pthread_mutex_lock(&buffer->mutex));                                                          \
+  while(buffer->tail - buffer->head == (N)){                                                                           \
+    Name##_recover(buffer, pthread_cond_wait(&buffer->writeBlock, &buffer->mutex));                                    \
+  }                                                                                                                    \
+                                                                                                                       \
+  buffer->slots[BOUNDED_BUFFER_SLOT(buffer->tail, N)] = *element;                                                      \
+  buffer->tail++;                                                                                                      \
+                                                                                                                       \
+  if(buffer->tail - buffer->head == 1){                                                                                \
+    pthread_cond_broadcast(&buffer->readBlock);                                                                        \
+  }                                                                                                                    \
+  pthread_mutex_unlock(&buffer->mutex);                                                                                \
+  return 0;                                                                                                            \
+}                                                                                                                      \
+                                                                                                                       \
+/* Move the oldest element out, blocking while the buffer is empty and open.  Returns -1 once closed and empty. */     \
+static inline int Name##_get(Name* buffer, T* element)                                                                 \
+{                                                                                                                      \
+  Name##_recover(buffer, pthread_mutex_lock(&buffer->mutex));                                                          \
+  while(buffer->tail == buffer->head && !buffer->closed){                                                              \
+    Name##_recover(buffer, pthread_cond_wait(&buffer->readBlock, &buffer->mutex));                                     \
+  }                                                                                                                    \
+                                                                                                                       \
+  if(buffer->tail == buffer->head){                                                                                    \
+    pthread_mutex_unlock(&buffer->mutex);                                                                              \
+    return -1;                                                                                                         \
+  }                                                                                                                    \
+                                                                                                                       \
+  *element = buffer->slots[BOUNDED_BUFFER_SLOT(buffer->head, N)];                                                      \
+  buffer->head++;                                                                                                      \
+                                                                                                                       \
+  if(buffer->tail - buffer->head == (N) - 1){                                                                          \
+    pthread_cond_broadcast(&buffer->writeBlock);                                                                       \
+  }                                                                                                                    \
+  pthread_mutex_unlock(&buffer->mutex);                                                                                \
+  return 0;                                                                                                            \
+}                                                                                                                      \
+                                                                                                                       \
+/* Move the oldest element out if there is one, without blocking.  Returns -1 if the buffer is empty. */               \
+static inline int Name##_try_get(Name* buffer, T* element)                                                             \
+{                                                                                                                      \
+  Name##_recover(buffer, pthread_mutex_lock(&buffer->mutex));                                                          \
+  if(buffer->tail == buffer->head){                                                                                    \
+    pthread_mutex_unlock(&buffer->mutex);                                                                              \
+    return -1;                                                                                                         \
+  }                                                                                                                    \
+                                                                                                                       \
+  *element = buffer->slots[BOUNDED_BUFFER_SLOT(buffer->head, N)];                                                      \
+  buffer->head++;                                                                                                      \
+                                                                                                                       \
+  if(buffer->tail - buffer->head == (N) - 1){                                                                          \
+    pthread_cond_broadcast(&buffer->writeBlock);                                                                       \
+  }                                                                                                                    \
+  pthread_mutex_unlock(&buffer->mutex);                                                                                \
+  return 0;                                                                                                            \
+}                                                                                                                      \
+                                                                                                                       \
+/* Mark the buffer closed, waking every blocked reader.  Returns 0. */                                                 \
+static inline int Name##_close(Name* buffer)                                                                           \
+{                                                                                                                      \
+  Name##_recover(buffer, pthread_mutex_lock(&buffer->mutex));                                                          \
+  buffer->closed = 1;                                                                                                  \
+  pthread_cond_broadcast(&buffer->readBlock);                                                                          \
+  pthread_mutex_unlock(&buffer->mutex);                                                                                \
+  return 0;                                                                                                            \
+}                                                                                                                      \
+                                                                                                                       \
+static inline int Name##_is_closed(Name* buffer)                                                                       \
+{                                                                                                                      \
+  return buffer->closed;                                                                                               \
+}                                                                                                                      \
+                                                                                                                       \
+static inline int Name##_count(Name* buffer)                                                                           \
+{                                                                                                                      \
+  return buffer->tail - buffer->head;                                                                                  \
+}                                                                                                                      \
+                                                                                                                       \
+/* Destroy the buffer's primitives.  Only the process that initialized it may do so. */                                \
+static inline void Name##_destroy(Name* buffer)                                                                        \
+{                                                                                                                      \
+  pthread_mutex_destroy(&buffer->mutex);                                                                               \
+  pthread_cond_destroy(&buffer->readBlock);                                                                            \
+  pthread_cond_destroy(&buffer->writeBlock);                                                                           \
+}
+
+#endif
@@ -0,0 +1,369 @@
+/*
+ *  CSCI-3753 Design and Analysis of Operating Systems PA3 Bounded Buffer problem - checkpoint definition.
+ *
+ *  A checkpoint file looks like this:
+ *
+ *    multi-lookup-checkpoint 1
+ *    results <size of results log>
+ *    serviced <size of serviced log>
+ *    <complete> <watermark> <logged> <n> <offset 1> ... <offset n> <input file name>
+ *    ...
+ *
+ *  with one line per input file, where the n offsets are the starts of lines past the watermark which are already
+ *  in the serviced log.  The name comes last so that it may contain spaces.
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include "checkpoint.h"
+
+#define CHECKPOINT_HEADER "multi-lookup-checkpoint 1"
+#define CHECKPOINT_LINE_LENGTH 65536
+
+// Comparison for sorting and searching the list of lines to skip.
+static int compare_offsets(const void* a, const void* b)
+{
+  long x = *(const long *) a;
+  long y = *(const long *) b;
+  return (x > y) - (x < y);
+}
+
+// Mark a line done and advance the watermark over every done line.  The caller must hold the Input's lock.
+static void mark_done(Input* file, long seq, long start, long end)
+{
+  Span* slot = &file->ahead[seq % CHECKPOINT_WINDOW];
+  slot->start = start;
+  slot->end = end;
+
+  int advanced = 0;
+  for(slot = &file->ahead[file->nextSeq % CHECKPOINT_WINDOW]; slot->end > 0; slot = &file->ahead[file->nextSeq % CHECKPOINT_WINDOW]){
+    file->watermark = slot->end;
+    slot->end = 0;
+    file->nextSeq++;
+    advanced = 1;
+  }
+
+  if(file->eof && file->nextSeq == file->lines){
+    file->complete = 1;
+  }
+
+  // Let the requester read further ahead, if it was waiting for the window to move.
+  if(advanced){
+    pthread_cond_broadcast(&file->progress);
+  }
+}
+
+// Definition of checkpoint_init method.
+int checkpoint_init(Checkpoint* cp, char* name, int interval, FileList* files, OutFile* results, OutFile* serviced)
+{
+  cp->name = name;
+  cp->interval = interval;
+  cp->last = time(NULL);
+  cp->files = files;
+  cp->results = results;
+  cp->serviced = serviced;
+
+  if(pthread_mutex_init(&cp->lock, NULL) != 0){
+    printf("%s\n", "ERROR: Failed to initialize checkpoint mutex!");
+    return -1;
+  }
+
+  return 0;
+}
+
+// Definition of checkpoint_load method.
+int checkpoint_load(char* name, FileList* files, long* resultsSize, long* servicedSize)
+{
+  FILE* fd = fopen(name, "r");
+  if(fd == NULL){
+    return errno == ENOENT ? 1 : -1;
+  }
+
+  char* line = malloc(CHECKPOINT_LINE_LENGTH);
+  char* matched = calloc(files->total + 1, sizeof(char));
+  int err = -1;
+  if(line == NULL || matched == NULL){
+    goto out;
+  }
+
+  // Check the header and the log sizes.
+  if(fgets(line, CHECKPOINT_LINE_LENGTH, fd) == NULL || strncmp(line, CHECKPOINT_HEADER, strlen(CHECKPOINT_HEADER)) != 0){
+    goto out;
+  }
+  if(fscanf(fd, "results %ld\nserviced %ld\n", resultsSize, servicedSize) != 2){
+    goto out;
+  }
+
+  while(fgets(line, CHECKPOINT_LINE_LENGTH, fd) != NULL){
+    int complete, numSkip, used;
+    long watermark, logged;
+    char* p = line;
+
+    if(sscanf(p, "%d %ld %ld %d%n", &complete, &watermark, &logged, &numSkip, &used) != 4 || numSkip < 0){
+      goto out;
+    }
+    p += used;
+
+    long* skip = NULL;
+    if(numSkip > 0){
+      skip = malloc(numSkip * sizeof(long));
+      if(skip == NULL){
+	goto out;
+      }
+    }
+    for(int i = 0; i < numSkip; i++){
+      if(sscanf(p, " %ld%n", &skip[i], &used) != 1){
+	free(skip);
+	goto out;
+      }
+      p += used;
+    }
+
+    // What is left is a single space and the name of the input file.
+    if(*p == ' '){
+      p++;
+    }
+    p[strcspn(p, "\n")] = '\0';
+
+    // Hand the progress to the first input file of that name that doesn't have any yet.
+    int i;
+    for(i = 0; i < files->total; i++){
+      if(!matched[i] && strcmp(files->list[i].name, p) == 0){
+	break;
+      }
+    }
+    if(i == files->total){
+      free(skip);
+      continue;
+    }
+
+    Input* file = &files->list[i];
+    matched[i] = 1;
+    file->complete = complete;
+    file->watermark = watermark;
+    file->position = watermark;
+    file->logged = logged;
+    file->numSkip = numSkip;
+    file->skip = skip;
+    if(numSkip > 0){
+      qsort(file->skip, numSkip, sizeof(long), compare_offsets);
+    }
+  }
+  err = 0;
+
+ out:
+  if(err != 0){
+    printf("%s%s%s\n", "ERROR: Checkpoint file ", name, " is malformed!");
+  }
+  free(line);
+  free(matched);
+  fclose(fd);
+  return err;
+}
+
+// Definition of checkpoint_start method.
+int checkpoint_start(Input* file)
+{
+  pthread_mutex_lock(&file->lock);
+  if(file->complete){
+    pthread_mutex_unlock(&file->lock);
+    return 1;
+  }
+
+  if(file->ahead == NULL){
+    file->ahead = calloc(CHECKPOINT_WINDOW, sizeof(Span));
+  }
+  int err = file->ahead == NULL ? -1 : 0;
+  pthread_mutex_unlock(&file->lock);
+  return err;
+}
+
+// Definition of checkpoint_read method.
+int checkpoint_read(Input* file, long seq, long start, long end)
+{
+  pthread_mutex_lock(&file->lock);
+
+  // Don't run so far ahead of the watermark that this line's slot in the window is still in use.
+  while(seq - file->nextSeq >= CHECKPOINT_WINDOW){
+    pthread_cond_wait(&file->progress, &file->lock);
+  }
+  file->position = end;
+
+  // Lines the last run already wrote to the serviced log are done as soon as they are read.
+  if(file->numSkip > 0 && bsearch(&start, file->skip, file->numSkip, sizeof(long), compare_offsets) != NULL){
+    mark_done(file, seq, start, end);
+    pthread_mutex_unlock(&file->lock);
+    return LINE_SERVICED;
+  }
+
+  int state = start < file->logged ? LINE_LOGGED : LINE_NEW;
+  pthread_mutex_unlock(&file->lock);
+  return state;
+}
+
+// Definition of checkpoint_logged method.
+void checkpoint_logged(Input* file, long end)
+{
+  pthread_mutex_lock(&file->lock);
+  file->logged = end;
+  pthread_mutex_unlock(&file->lock);
+}
+
+// Definition of checkpoint_done method.
+void checkpoint_done(Input* file, long seq, long start, long end)
+{
+  pthread_mutex_lock(&file->lock);
+  mark_done(file, seq, start, end);
+  pthread_mutex_unlock(&file->lock);
+}
+
+// Definition of checkpoint_eof method.
+void checkpoint_eof(Input* file, long lines)
+{
+  pthread_mutex_lock(&file->lock);
+  file->lines = lines;
+  file->eof = 1;
+  if(file->nextSeq == file->lines){
+    file->complete = 1;
+  }
+  pthread_mutex_unlock(&file->lock);
+}
+
+// Write a snapshot.  The caller must hold the Checkpoint's lock.
+static int write_snapshot(Checkpoint* cp)
+{
+  char temp[PATH_MAX];
+  snprintf(temp, sizeof(temp), "%s.tmp", cp->name);
+
+  FILE* fd = fopen(temp, "w");
+  if(fd == NULL){
+    printf("%s%s%s\n", "ERROR: Failed to open checkpoint file ", temp, "!");
+    return -1;
+  }
+
+  // Hold both logs still while we look at them, so the snapshot matches what is actually in them.
+  pthread_mutex_lock(&cp->results->lock);
+  pthread_mutex_lock(&cp->serviced->lock);
+  struct stat results, serviced;
+  fflush(cp->results->fd);
+  fflush(cp->serviced->fd);
+  fstat(fileno(cp->results->fd), &results);
+  fstat(fileno(cp->serviced->fd), &serviced);
+
+  fprintf(fd, "%s\nresults %ld\nserviced %ld\n", CHECKPOINT_HEADER, (long) results.st_size, (long) serviced.st_size);
+  for(int i = 0; i < cp->files->total; i++){
+    Input* file = &cp->files->list[i];
+    pthread_mutex_lock(&file->lock);
+
+    // Lines past the watermark which are done: those finished this run, and those from the last run not yet reached.
+    int numSkip = 0;
+    if(file->ahead != NULL){
+      for(int j = 0; j < CHECKPOINT_WINDOW; j++){
+	numSkip += file->ahead[j].end > 0;
+      }
+    }
+    for(int j = 0; j < file->numSkip; j++){
+      numSkip += file->skip[j] >= file->position;
+    }
+
+    fprintf(fd, "%d %ld %ld %d", file->complete, file->watermark, file->logged, numSkip);
+    if(file->ahead != NULL){
+      for(int j = 0; j < CHECKPOINT_WINDOW; j++){
+	if(file->ahead[j].end > 0){
+	  fprintf(fd, " %ld", file->ahead[j].start);
+	}
+      }
+    }
+    for(int j = 0; j < file->numSkip; j++){
+      if(file->skip[j] >= file->position){
+	fprintf(fd, " %ld", file->skip[j]);
+      }
+    }
+    fprintf(fd, " %s\n", file->name);
+    pthread_mutex_unlock(&file->lock);
+  }
+
+  pthread_mutex_unlock(&cp->serviced->lock);
+  pthread_mutex_unlock(&cp->results->lock);
+
+  // The snapshot vouches for the logs up to the sizes it records, so they have to reach the disk before it does.  They
+  // were flushed under their locks; syncing everything written since as well does no harm, and the threads needn't wait.
+  int err = fsync(fileno(cp->results->fd)) | fsync(fileno(cp->serviced->fd));
+
+  // Only replace the old snapshot once the new one is completely written, and on disk.
+  if(fflush(fd) != 0 || fsync(fileno(fd)) != 0){
+    err = -1;
+  }
+  if(fclose(fd) != 0){
+    err = -1;
+  }
+  if(err == 0){
+    err = rename(temp, cp->name);
+  }
+
+  // And make the rename itself stick, by syncing the directory that holds the snapshot.
+  if(err == 0){
+    char dir[PATH_MAX];
+    snprintf(dir, sizeof(dir), "%s", cp->name);
+    int dirFd = open(dirname(dir), O_RDONLY | O_DIRECTORY);
+    if(dirFd < 0 || fsync(dirFd) != 0){
+      err = -1;
+    }
+    if(dirFd >= 0){
+      close(dirFd);
+    }
+  }
+  cp->last = time(NULL);
+
+  if(err != 0){
+    printf("%s%s%s\n", "ERROR: Failed to write checkpoint file ", cp->name, "!");
+    return -1;
+  }
+  return 0;
+}
+
+// Definition of checkpoint_maybe method.
+int checkpoint_maybe(Checkpoint* cp)
+{
+  // A racy peek is fine here; the worst case is one extra check under the lock.
+  if(time(NULL) - cp->last < cp->interval){
+    return 0;
+  }
+
+  // If another thread is already writing a snapshot, this one isn't needed.
+  if(pthread_mutex_trylock(&cp->lock) != 0){
+    return 0;
+  }
+  int err = 0;
+  if(time(NULL) - cp->last >= cp->interval){
+    err = write_snapshot(cp);
+  }
+  pthread_mutex_unlock(&cp->lock);
+  return err;
+}
+
+// Definition of checkpoint_write method.
+int checkpoint_write(Checkpoint* cp)
+{
+  pthread_mutex_lock(&cp->lock);
+  int err = write_snapshot(cp);
+  pthread_mutex_unlock(&cp->lock);
+  return err;
+}
+
+// Definition of checkpoint_destroy method.
+void checkpoint_destroy(Checkpoint* cp)
+{
+  for(int i = 0; i < cp->files->total; i++){
+    free(cp->files->list[i].ahead);
+    free(cp->files->list[i].skip);
+    cp->files->list[i].ahead = NULL;
+    cp->files->list[i].skip = NULL;
+  }
+  pthread_mutex_destroy(&cp->lock);
+}
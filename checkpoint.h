@@ -0,0 +1,124 @@
+/*
+ *  CSCI-3753 Design and Analysis of Operating Systems, PA3 Bounded Buffer Problem - checkpoint header file.
+ *
+ *  Checkpointing lets a long run that dies be resumed instead of started over.  Requesters and resolvers record
+ *  their progress through each input file in its Input struct (see input_processor.h), and every so often a
+ *  requester writes a snapshot of that progress, together with the sizes of the results and serviced logs, to a
+ *  small text file.  A resumed run cuts both logs back to the recorded sizes, skips every line the snapshot says is
+ *  already in the serviced log, and only appends results lines the results log doesn't have yet, so neither log
+ *  ends up with duplicate lines.
+ *
+ *  Lock order: a Checkpoint's lock, then the results log's lock, then the serviced log's lock, then an Input's lock.
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <pthread.h>
+#include <time.h>
+#include "input_processor.h"
+
+// How many lines of one file may be in flight at once.  A requester waits before reading further ahead than this.
+#define CHECKPOINT_WINDOW 256
+
+// What a requester should do with a line it has just read, as decided by checkpoint_read.
+#define LINE_NEW 0
+#define LINE_LOGGED 1
+#define LINE_SERVICED 2
+
+typedef struct Checkpoint{
+  pthread_mutex_t lock;
+  char* name;
+  int interval;
+  time_t last;
+  FileList* files;
+  OutFile* results;
+  OutFile* serviced;
+} Checkpoint;
+
+/*
+ *  Prototype of checkpoint_init method.
+ *  This method initializes a Checkpoint struct and its mutex lock.  No snapshot is written until the first interval
+ *  has passed.
+ *  Params:  the struct to initialize, the name of the checkpoint file, the number of seconds between snapshots, the
+ *  list of input files, and the results and serviced logs exactly as the requester and resolver threads use them.
+ *  Returns 0 on success, -1 if the mutex lock could not be initialized.
+ */
+int checkpoint_init(Checkpoint* cp, char* name, int interval, FileList* files, OutFile* results, OutFile* serviced);
+
+/*
+ *  Prototype of checkpoint_load method.
+ *  This method reads a checkpoint file written by an earlier run and moves the progress of every input file it
+ *  mentions (matched by name) forward to where that run left off.  It must be called before any requester starts.
+ *  Params:  the name of the checkpoint file, the list of input files, and the sizes the results and serviced logs
+ *  should be cut back to, which are filled in.
+ *  Returns 0 on success, 1 if there is no checkpoint file, -1 if the checkpoint file is malformed.
+ */
+int checkpoint_load(char* name, FileList* files, long* resultsSize, long* servicedSize);
+
+/*
+ *  Prototype of checkpoint_start method.
+ *  This method is called by a requester when it claims an input file, before opening it.  It allocates the file's
+ *  window of in-flight lines.  Reading should then pick up from the file's watermark, where the last run left off.
+ *  Params:  the input file being claimed.
+ *  Returns 0 on success, 1 if the file is already complete, -1 on failure.
+ */
+int checkpoint_start(Input* file);
+
+/*
+ *  Prototype of checkpoint_read method.
+ *  This method is called by a requester for every line it reads, before the line goes anywhere.  It waits while the
+ *  line would fall outside the window of in-flight lines, records that the line has been read, and tells the
+ *  requester whether the line is new, already in the results log, or already in the serviced log as well (in which
+ *  case it counts as done and must not be enqueued).
+ *  Params:  the input file, the line's number, the byte offsets of its start and end.
+ *  Returns LINE_NEW, LINE_LOGGED or LINE_SERVICED.
+ */
+int checkpoint_read(Input* file, long seq, long start, long end);
+
+/*
+ *  Prototype of checkpoint_logged method.
+ *  This method records that a line has been written to the results log.  It must be called while holding the results
+ *  log's lock, so that a snapshot never sees the log and the progress disagree.
+ *  Params:  the input file, the byte offset just past the line.
+ */
+void checkpoint_logged(Input* file, long end);
+
+/*
+ *  Prototype of checkpoint_done method.
+ *  This method records that a line has been written to the serviced log, and moves the file's watermark past every
+ *  line that is now done.  It must be called while holding the serviced log's lock.
+ *  Params:  the input file, the line's number, the byte offsets of its start and end.
+ */
+void checkpoint_done(Input* file, long seq, long start, long end);
+
+/*
+ *  Prototype of checkpoint_eof method.
+ *  This method records that a requester has read every line of a file.
+ *  Params:  the input file, the number of lines that were read from it by this run.
+ */
+void checkpoint_eof(Input* file, long lines);
+
+/*
+ *  Prototype of checkpoint_maybe method.
+ *  This method writes a snapshot if the interval has passed since the last one.  It is cheap enough to call once per
+ *  line, and never makes a caller wait for a snapshot another thread is already writing.
+ *  Returns 0 on success or if no snapshot was due, -1 if the snapshot could not be written.
+ */
+int checkpoint_maybe(Checkpoint* cp);
+
+/*
+ *  Prototype of checkpoint_write method.
+ *  This method writes a snapshot of every input file's progress and the sizes of both logs.  The snapshot is written
+ *  to a temporary file and renamed over the old one, so a crash while writing it leaves the previous snapshot intact.
+ *  Returns 0 on success, -1 on failure.
+ */
+int checkpoint_write(Checkpoint* cp);
+
+/*
+ *  Prototype of checkpoint_destroy method.
+ *  This method frees the per-file progress memory and destroys the Checkpoint's mutex lock.
+ */
+void checkpoint_destroy(Checkpoint* cp);
+
+#endif
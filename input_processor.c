@@ -3,8 +3,41 @@
  *  Created by Jeff Colgan; April 4, 2021.
  */
 
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include <dirent.h>
+#include <limits.h>
+#include <sys/stat.h>
 #include "input_processor.h"
 
+#define MANIFEST_LINE_LENGTH 4096
+
+// Open an output log, either from scratch or, when resuming, cut back to the size the checkpoint recorded for it.  A log
+// shorter than that has lost lines the checkpoint counts as written, and growing it would only pad it with zero bytes.
+static FILE* open_log(char* log, long keep)
+{
+  if(keep < 0){
+    return fopen(log, "w");
+  }
+
+  FILE* fd = fopen(log, "a");
+  if(fd == NULL){
+    return NULL;
+  }
+  struct stat info;
+  if(fstat(fileno(fd), &info) != 0 || info.st_size < keep){
+    fprintf(stderr, "%s%s%s%ld%s\n", "ERROR: ", log, " is shorter than the ", keep, " bytes the checkpoint says it holds, so the run can't be resumed!");
+    fclose(fd);
+    return NULL;
+  }
+  if(ftruncate(fileno(fd), keep) != 0){
+    fclose(fd);
+    return NULL;
+  }
+  return fd;
+}
+
 // Definition of create_file_list method.
 FileList* create_file_list(int total){
   FileList* list;
@@ -32,17 +65,167 @@ FileList* create_file_list(int total){
   return list;
 }
 
+// A file's place in the claim order, for sorting by size.
+typedef struct ClaimEntry{
+  long size;
+  int index;
+} ClaimEntry;
+
+// Most left to read first, and files with as much left in input order.
+static int compare_claims(const void* a, const void* b)
+{
+  const ClaimEntry* x = (const ClaimEntry *) a;
+  const ClaimEntry* y = (const ClaimEntry *) b;
+  if(x->size != y->size){
+    return x->size > y->size ? -1 : 1;
+  }
+  return x->index - y->index;
+}
+
+// Add a copy of a name to a growing list of names.
+static int add_input(char*** names, int* total, int* capacity, const char* name)
+{
+  if(*total == *capacity){
+    int grown = *capacity > 0 ? *capacity * 2 : 64;
+    char** list = realloc(*names, grown * sizeof(char*));
+    if(list == NULL){
+      return -1;
+    }
+    *names = list;
+    *capacity = grown;
+  }
+
+  (*names)[*total] = strdup(name);
+  if((*names)[*total] == NULL){
+    return -1;
+  }
+  (*total)++;
+  return 0;
+}
+
+// Comparison for sorting the names found in an input directory.
+static int compare_names(const void* a, const void* b)
+{
+  return strcmp(*(char* const *) a, *(char* const *) b);
+}
+
+// Definition of collect_inputs method.
+int collect_inputs(int count, char* files[], char* manifest, char* directory, char*** names){
+  int total = 0;
+  int capacity = 0;
+  *names = NULL;
+
+  // Input files given on the command line come first.
+  for(int i = 0; i < count; i++){
+    if(add_input(names, &total, &capacity, files[i]) != 0){
+      goto fail;
+    }
+  }
+
+  // Then one input file per line of the manifest, ignoring blank lines.
+  if(manifest != NULL){
+    FILE* fd = fopen(manifest, "r");
+    if(fd == NULL){
+      printf("%s%s%s\n", "ERROR: Failed to open manifest ", manifest, "!");
+      goto fail;
+    }
+
+    char line[MANIFEST_LINE_LENGTH];
+    while(fgets(line, sizeof(line), fd) != NULL){
+      line[strcspn(line, "\r\n")] = '\0';
+      if(line[0] != '\0' && add_input(names, &total, &capacity, line) != 0){
+	fclose(fd);
+	goto fail;
+      }
+    }
+    fclose(fd);
+  }
+
+  // Then every regular file in the input directory, sorted so that runs (and checkpoints) see them in the same order.
+  if(directory != NULL){
+    DIR* dir = opendir(directory);
+    if(dir == NULL){
+      printf("%s%s%s\n", "ERROR: Failed to open input directory ", directory, "!");
+      goto fail;
+    }
+
+    int first = total;
+    struct dirent* entry;
+    char path[PATH_MAX];
+    while((entry = readdir(dir)) != NULL){
+      if(entry->d_name[0] == '.'){
+	continue;
+      }
+      snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+
+      // Not every filesystem fills in d_type, so fall back to stat when it doesn't.
+      struct stat info;
+      if(entry->d_type != DT_REG && (entry->d_type != DT_UNKNOWN || stat(path, &info) != 0 || !S_ISREG(info.st_mode))){
+	continue;
+      }
+      if(add_input(names, &total, &capacity, path) != 0){
+	closedir(dir);
+	goto fail;
+      }
+    }
+    closedir(dir);
+    qsort(*names + first, total - first, sizeof(char*), compare_names);
+  }
+
+  return total;
+
+ fail:
+  free_inputs(total, *names);
+  *names = NULL;
+  return -1;
+}
+
+// Definition of free_inputs method.
+void free_inputs(int total, char** names){
+  for(int i = 0; i < total; i++){
+    free(names[i]);
+  }
+  free(names);
+}
+
 // Definition of open_files method.
-int open_files(int total, FileList* list, char* files[]){
+int open_files(int total, FileList* list, char* files[], int maxOpen, int readAhead){
 
   int err;
-  // Get the data files from argv.
+  struct stat info;
+
+  // Set up the descriptor budget shared by every requester.
+  list->readAhead = readAhead;
+  list->hinted = 0;
+  if(sem_init(&list->budget, 0, maxOpen) != 0){
+    printf("%s\n", "ERROR: Failed to initialize input file descriptor budget!");
+    free(list);
+    return -1;
+  }
+
+  // Get the data files from the list of names.
   for(int i = 0; i < total; i++){
     Input file;
     err = pthread_mutex_init(&file.lock, NULL);
+    if(err == 0){
+      err = pthread_cond_init(&file.progress, NULL);
+    }
     file.complete = 0;
-    file.name = files[i+5];
-    file.fd = fopen(file.name, "r");
+    file.name = files[i];
+    file.fd = NULL;
+
+    // Nothing has been read yet; a resumed checkpoint may move these forward before any requester starts.
+    file.watermark = 0;
+    file.nextSeq = 0;
+    file.position = 0;
+    file.logged = 0;
+    file.ahead = NULL;
+    file.skip = NULL;
+    file.numSkip = 0;
+    file.lines = 0;
+    file.eof = 0;
+    file.size = stat(files[i], &info) == 0 && S_ISREG(info.st_mode) ? (long) info.st_size : -1;
+    file.rank = i;
     list->list[i] = file;
 
     // Verify that the data files' mutex locks initialized properly.
@@ -56,13 +239,120 @@ int open_files(int total, FileList* list, char* files[]){
   return 0;
 }
 
+// Definition of order_files method.
+int order_files(FileList* list, int bySize){
+  int total = list->total;
+
+  // Only what is left past each file's watermark is still to be read.  Files that couldn't be stat'ed have size -1, so
+  // they go after every file with anything left, and files a resumed checkpoint says are complete go last of all.
+  ClaimEntry* claims = malloc((total + 1) * sizeof(ClaimEntry));
+  list->order = malloc((total + 1) * sizeof(int));
+  if(claims == NULL || list->order == NULL){
+    printf("%s\n", "ERROR: Failed to allocate memory for input file order!");
+    free(claims);
+    free(list->order);
+    list->order = NULL;
+    return -1;
+  }
+  for(int i = 0; i < total; i++){
+    Input* file = &list->list[i];
+    if(file->complete){
+      claims[i].size = -2;
+    }else if(file->size < 0){
+      claims[i].size = -1;
+    }else{
+      claims[i].size = file->size > file->watermark ? file->size - file->watermark : 0;
+    }
+    claims[i].index = i;
+  }
+  if(bySize){
+    qsort(claims, total, sizeof(ClaimEntry), compare_claims);
+  }
+  for(int i = 0; i < total; i++){
+    list->order[i] = claims[i].index;
+    list->list[claims[i].index].rank = i;
+  }
+  free(claims);
+
+  return 0;
+}
+
+// Definition of claim_input method.
+int claim_input(FileList* list){
+  sem_wait(&list->budget);
+
+  pthread_mutex_lock(&list->lock);
+  int index = -1;
+  if(list->current < list->total){
+    index = list->order[list->current++];
+  }
+  pthread_mutex_unlock(&list->lock);
+
+  // Nothing left to claim, so the descriptor isn't needed after all.
+  if(index < 0){
+    sem_post(&list->budget);
+  }
+  return index;
+}
+
+// Definition of open_input method.
+int open_input(FileList* list, int index){
+  Input* file = &list->list[index];
+
+  // Open the file for sequential reading.
+  file->fd = fopen(file->name, "r");
+  if(file->fd == NULL){
+    fprintf(stderr, "%s%s%s\n", "ERROR: Failed to open input file ", file->name, "!");
+    return -1;
+  }
+  posix_fadvise(fileno(file->fd), 0, 0, POSIX_FADV_SEQUENTIAL);
+
+  // Work out which of the next few files haven't been hinted yet, and claim them so no other requester hints them too.
+  pthread_mutex_lock(&list->lock);
+  int rank = list->list[index].rank;
+  int first = list->hinted > rank + 1 ? list->hinted : rank + 1;
+  int last = rank + 1 + list->readAhead;
+  if(last > list->total){
+    last = list->total;
+  }
+  if(last > list->hinted){
+    list->hinted = last;
+  }
+  pthread_mutex_unlock(&list->lock);
+
+  // Ask the kernel to start reading them in.  This only borrows spare descriptors, and never waits for one.
+  for(int i = first; i < last; i++){
+    if(sem_trywait(&list->budget) != 0){
+      break;
+    }
+    int fd = open(list->list[list->order[i]].name, O_RDONLY);
+    if(fd >= 0){
+      posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+      close(fd);
+    }
+    sem_post(&list->budget);
+  }
+
+  return 0;
+}
+
+// Definition of close_input method.
+void close_input(FileList* list, int index){
+  Input* file = &list->list[index];
+  if(file->fd != NULL){
+    fclose(file->fd);
+    file->fd = NULL;
+  }
+  sem_post(&list->budget);
+}
+
 // Definition of open_results method.
-int open_results(OutFile* results, char* log){
+int open_results(OutFile* results, char* log, long keep){
 
   // Populate struct values for the results file to be written to by requester threads.
   int err = pthread_mutex_init(&results->lock, NULL);
   results->name = log;
-  results->fd = fopen(log, "w");
+  results->fd = open_log(log, keep);
 
   // Return error state if the mutex lock failed to initialize.
   if(err != 0){
@@ -81,12 +371,12 @@ int open_results(OutFile* results, char* log){
 }
 
 // Definition of open_serviced method.
-int open_serviced(OutFile* serviced, char* log){
+int open_serviced(OutFile* serviced, char* log, long keep){
 
   // Populate stuct values for the serviced file to be written to by requester theads.
   int err = pthread_mutex_init(&serviced->lock, NULL);
   serviced->name = log;
-  serviced->fd = fopen(log, "w");
+  serviced->fd = open_log(log, keep);
 
   // Return error state if the mutex lock failed to initialize.
   if(err != 0){
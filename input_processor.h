@@ -8,40 +8,111 @@
  *  to deal with the various input and output files that are used by my implementation of multi-lookup.
  */
 
+#ifndef INPUT_PROCESSOR_H
+#define INPUT_PROCESSOR_H
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <pthread.h>
 #include <semaphore.h>
 
+// The byte offsets of the start and end of one line of an input file.
+typedef struct Span{
+  long start;
+  long end;
+} Span;
+
 typedef struct OutFile{
   pthread_mutex_t lock;
   FILE* fd;
   char* name;
 } OutFile;
 
+/*
+ *  Besides the file itself, each Input tracks how far through it this run (and any run it resumed) has got, for
+ *  checkpointing.  complete and every member from watermark on are protected by the Input's lock:
+ *    complete   - every line of the file has been resolved and written to the serviced log.
+ *    watermark  - every line before this byte offset has been resolved and written to the serviced log.
+ *    nextSeq    - the line number of the line starting at watermark.
+ *    position   - the byte offset just past the last line the requester has read.
+ *    logged     - every line before this byte offset has been written to the results log.
+ *    ahead      - lines after the watermark which are already in the serviced log, indexed by line number modulo
+ *                 CHECKPOINT_WINDOW.  Only allocated while the file is being read with checkpointing on.
+ *    skip       - lines after the watermark which a resumed checkpoint says are already in the serviced log.
+ *    lines      - the number of lines read, once eof is set.
+ *  size and rank are fixed before any requester starts: the file's size in bytes when the run started (-1 if it couldn't
+ *  be stat'ed or isn't a regular file, as with a pipe, whose size says nothing), and its place in the order files are
+ *  claimed in.
+ */
 typedef struct Input{
   pthread_mutex_t lock;
+  pthread_cond_t progress;
   FILE* fd;
   char* name;
   int complete;
+  long watermark;
+  long nextSeq;
+  long position;
+  long logged;
+  Span* ahead;
+  long* skip;
+  int numSkip;
+  long lines;
+  int eof;
+  long size;
+  int rank;
 } Input;
 
+/*
+ *  Input files are only opened once a requester claims them, and closed as soon as they have been read, so that any
+ *  number of them can be processed with a bounded number of descriptors.  The budget semaphore counts the descriptors
+ *  still available.  A requester takes a descriptor before it claims a file, so descriptors go to files in the order
+ *  they are claimed, and the earliest file still being read always has one.  hinted is the index of the first file after the ones whose reading ahead has already been
+ *  requested from the kernel; it only ever moves forward, protected by the FileList's lock.
+ *
+ *  Files are claimed in the order given by order, which holds the index of each file in list.  list itself always stays
+ *  in input order, since that is the order the output, checkpoints and reorder buffer refer to files in.  current and
+ *  hinted count positions in order, not indices in list.
+ */
 typedef struct FileList{
   pthread_mutex_t lock;
   int current;
   int total;
   int processed;
+  sem_t budget;
+  int readAhead;
+  int hinted;
+  int* order;
   Input list[];
 } FileList;
 
+struct Checkpoint;
+struct RateLimiter;
+struct Reorder;
+struct DnsServer;
+struct Pipeline;
+struct ResolverArgs;
+
 struct RequesterArgs{
   FileList* data;
   OutFile results;
+  struct Checkpoint* checkpoint;
+  struct Reorder* reorder;
+  struct ResolverArgs* next;
 };
 
+/*
+ *  Every stage after the read stage is given the same ResolverArgs, since whichever thread ends up running the format and
+ *  write stages needs the serviced log and everything that goes with it.
+ */
 struct ResolverArgs{
   FileList* data;
   OutFile serviced;
+  struct Checkpoint* checkpoint;
+  struct RateLimiter* limiter;
+  struct Reorder* reorder;
+  struct DnsServer* dnsServer;
+  struct Pipeline* pipeline;
 };
 
 /*
@@ -53,29 +124,95 @@ struct ResolverArgs{
  */
 FileList* create_file_list(int total);
 
+/*
+ *  Prototype of collect_inputs method.
+ *  This method gathers the names of every input file: those given on the command line, then those listed one per line
+ *  in a manifest file, then every regular file in an input directory (in name order).  Every name is copied, so the
+ *  list can be freed with free_inputs no matter where the names came from.
+ *  Params:  the number of input files given on the command line and their names, the manifest and directory (either may
+ *  be NULL), where to store the list of names.
+ *  Returns the number of input files, or -1 if the manifest or directory could not be read.
+ */
+int collect_inputs(int count, char* files[], char* manifest, char* directory, char*** names);
+
+/*
+ *  Prototype of free_inputs method.
+ *  This method frees a list of names built by collect_inputs.
+ */
+void free_inputs(int total, char** names);
+
 /*
  *  Prototype of open_files method.
- *  This method loops through all of the given input data files, opens them with fopen and initializes an Input struct
- *  with the appropriate values.  The files are added to the FileList struct, and each input file's mutex lock is initialized.
- *  Params:  total number of input files, list of input files struct used by multi-lookup, list of filenames to be opened provided
- *  by the userr.
+ *  This method loops through all of the given input data files and initializes an Input struct with the appropriate values.
+ *  The files are added to the FileList struct, and each input file's mutex lock is initialized.  No file is actually opened
+ *  here; see open_input.
+ *  Params:  total number of input files, list of input files struct used by multi-lookup, list of filenames provided by the
+ *  user, the most input files that may be open at once, and how many files past the one being opened to ask the kernel
+ *  to start reading ahead.  Each file's size is found with stat.  The files can't be claimed until order_files has run.
+ */
+int open_files(int total, FileList* list, char* files[], int maxOpen, int readAhead);
+
+/*
+ *  Prototype of order_files method.
+ *  This method works out the order requesters claim the input files in.  It must be called after any checkpoint has been
+ *  loaded, and before any requester starts.
+ *  Params:  list of input files struct used by multi-lookup, whether to hand the files out largest first instead of in
+ *  input order.
+ *  Largest means with the most bytes left past its watermark, so a resumed run weighs each file by the work it actually
+ *  has left.  Handing out the largest files first (longest processing time first) means the run doesn't end with one
+ *  requester working through a big file alone while the others sit idle.  Files already complete go last, where they
+ *  cost nothing.
+ *  Returns 0 on success, -1 if the order could not be allocated.
+ */
+int order_files(FileList* list, int bySize);
+
+/*
+ *  Prototype of claim_input method.
+ *  This method claims the next input file for a requester, waiting first for a descriptor to be free if the budget is
+ *  used up.  The descriptor is the requester's until it calls close_input on the file, whether or not it opens it.
+ *  Taking descriptors in claim order matters for ordered output: a requester that claimed a later file and then waits
+ *  for the earlier ones to catch up can never hold the descriptor an earlier file is waiting for.
+ *  Params:  the list of input files.
+ *  Returns the index of the claimed file, or -1 if every file has been claimed.
  */
-int open_files(int total, FileList* list, char* files[]);
+int claim_input(FileList* list);
+
+/*
+ *  Prototype of open_input method.
+ *  This method opens an input file a requester has just claimed, with the descriptor it claimed the file with.  The kernel is told the file will be read sequentially, and is asked to start reading ahead the next few
+ *  unclaimed files, so that they are already cached by the time they are claimed.  A file that fails to open is reported.
+ *  Params:  the list of input files, the index of the claimed file.
+ *  Returns 0 on success, -1 if the file could not be opened.
+ */
+int open_input(FileList* list, int index);
+
+/*
+ *  Prototype of close_input method.
+ *  This method closes an input file once it has been read, if it was opened at all, and returns the descriptor it was
+ *  claimed with to the budget.  It must be called exactly once for every claimed file.
+ */
+void close_input(FileList* list, int index);
 
 /*
  *  Prototype of open_results method.
  *  This method opens the provided results file to be written to by requester threads, initializes the members of the OutFile struct
- *  with the appropriate values, and initializes the mutex lock for the requester log.
- *  Params:  the struct repersenting the results file, the name of the file provided by the user.
+ *  with the appropriate values, and initializes the mutex lock for the requester log.  When resuming a checkpointed run
+ *  the file is cut back to the size recorded in the checkpoint and appended to, instead of being overwritten; it is an
+ *  error for it to be any shorter than that.
+ *  Params:  the struct repersenting the results file, the name of the file provided by the user, the size to keep
+ *  (or -1 to start a new file).
  */
-int open_results(OutFile* results, char* log);
+int open_results(OutFile* results, char* log, long keep);
 
 /*
  *  Prototype of open_serviced method.
  *  This method opens the provided serviced file to be written to by resolver threads, initializes the members of the OutFile struct
- *  with the appropriate values, and initializes the mutex lock for the resolver log.
- *  Params:  the struct representing the serviced file, the name of the file provided by the user.
+ *  with the appropriate values, and initializes the mutex lock for the resolver log.  When resuming a checkpointed run
+ *  the file is cut back to the size recorded in the checkpoint and appended to, instead of being overwritten; it is an
+ *  error for it to be any shorter than that.
+ *  Params:  the struct representing the serviced file, the name of the file provided by the user, the size to keep
+ *  (or -1 to start a new file).
  */
-int open_serviced(OutFile* serviced, char* log);
-
+int open_serviced(OutFile* serviced, char* log, long keep);
 
+#endif
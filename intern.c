@@ -0,0 +1,294 @@
+/*
+ *  CSCI-3753 Design and Analysis of Operating Systems PA3 Bounded Buffer problem - intern definition.
+ */
+
+#include <sys/mman.h>
+#include <pthread.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include "intern.h"
+
+// Whether a hostname's result has been stored.  A result is only read once it is RESULT_READY.
+#define RESULT_NONE 0
+#define RESULT_WRITING 1
+#define RESULT_READY 2
+
+// One interned hostname: where its name is in the arena, its bucket chain, and its lookup result.
+typedef struct InternRecord{
+  unsigned long offset;
+  uint32_t hash;
+  uint32_t next;
+  int state;
+  int err;
+  char ip[INET6_ADDRSTRLEN];
+} InternRecord;
+
+#define RECORD_CHUNKS (INTERN_MAX_IDS / INTERN_CHUNK_IDS)
+#define ARENA_CHUNKS ((int) (INTERN_ARENA_SIZE / INTERN_ARENA_CHUNK))
+
+// Memory mapped in chunks of a fixed size.  Chunks mapped together are contiguous, but only the chunk pointers are
+// ever used to find anything, so chunks mapped later can go anywhere.
+typedef struct Chunks{
+  char* chunk[RECORD_CHUNKS > ARENA_CHUNKS ? RECORD_CHUNKS : ARENA_CHUNKS];
+  void* map[RECORD_CHUNKS > ARENA_CHUNKS ? RECORD_CHUNKS : ARENA_CHUNKS];
+  size_t mapSize[RECORD_CHUNKS > ARENA_CHUNKS ? RECORD_CHUNKS : ARENA_CHUNKS];
+  size_t chunkSize;
+  int max;
+  int mapped;
+  int maps;
+} Chunks;
+
+// Shared with worker processes.
+static Chunks records;
+static Chunks arena;
+
+// Private to the main process, which is the only one that interns.
+static uint32_t* buckets;
+static uint32_t numBuckets;
+static pthread_mutex_t locks[INTERN_LOCKS];
+static pthread_mutex_t allocLock = PTHREAD_MUTEX_INITIALIZER;
+static int growable;
+static uint32_t count;
+static unsigned long used;
+
+// FNV-1a hash of a hostname.
+static uint32_t hash_hostname(const char* hostname)
+{
+  uint32_t hash = 2166136261u;
+  for(const unsigned char* p = (const unsigned char *) hostname; *p != '\0'; p++){
+    hash = (hash ^ *p) * 16777619u;
+  }
+  return hash;
+}
+
+// Map some more chunks, shared so that worker processes forked afterwards see them.  Memory is only committed as it is
+// touched, which for both tables is in order as names arrive.
+static int map_chunks(Chunks* chunks, int number)
+{
+  if(chunks->mapped + number > chunks->max){
+    return -1;
+  }
+  size_t size = number * chunks->chunkSize;
+  char* memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if(memory == MAP_FAILED){
+    return -1;
+  }
+  chunks->map[chunks->maps] = memory;
+  chunks->mapSize[chunks->maps] = size;
+  chunks->maps++;
+  for(int i = 0; i < number; i++){
+    chunks->chunk[chunks->mapped++] = memory + i * chunks->chunkSize;
+  }
+  return 0;
+}
+
+// Unmap every chunk.
+static void unmap_chunks(Chunks* chunks)
+{
+  for(int i = 0; i < chunks->maps; i++){
+    munmap(chunks->map[i], chunks->mapSize[i]);
+  }
+  chunks->mapped = 0;
+  chunks->maps = 0;
+}
+
+// The record of an ID.
+static InternRecord* record(uint32_t id)
+{
+  return (InternRecord *) records.chunk[id / INTERN_CHUNK_IDS] + id % INTERN_CHUNK_IDS;
+}
+
+// The name at an offset in the arena.  A name never runs from one chunk into the next.
+static char* arena_name(unsigned long offset)
+{
+  return arena.chunk[offset / INTERN_ARENA_CHUNK] + offset % INTERN_ARENA_CHUNK;
+}
+
+// Definition of normalize_hostname method.
+int normalize_hostname(char* hostname)
+{
+  // Trim the whitespace around the hostname, including the carriage return a file with DOS line endings leaves behind.
+  size_t length = strlen(hostname);
+  while(length > 0 && isspace((unsigned char) hostname[length - 1])){
+    hostname[--length] = '\0';
+  }
+  size_t lead = 0;
+  while(lead < length && isspace((unsigned char) hostname[lead])){
+    lead++;
+  }
+  if(lead > 0){
+    length -= lead;
+    memmove(hostname, hostname + lead, length + 1);
+  }
+
+  // "example.com." is the same fully qualified name as "example.com", and DNS names aren't case sensitive.
+  if(length > 0 && hostname[length - 1] == '.'){
+    hostname[--length] = '\0';
+  }
+  for(size_t i = 0; i < length; i++){
+    hostname[i] = tolower((unsigned char) hostname[i]);
+  }
+
+  if(length == 0 || length > MAX_HOSTNAME_LENGTH){
+    return -1;
+  }
+  size_t label = 0;
+  for(size_t i = 0; i <= length; i++){
+    if(hostname[i] == '.' || hostname[i] == '\0'){
+      if(label == 0 || label > MAX_LABEL_LENGTH){
+	return -1;
+      }
+      label = 0;
+    }else{
+      label++;
+    }
+  }
+  return 0;
+}
+
+// Definition of intern_init method.
+int intern_init(unsigned long bytes, int shared)
+{
+  // Every name but the empty one takes at least two bytes of input, a character and its newline, and its name in the
+  // arena is never longer than its line.  A name never straddles two arena chunks, which wastes less than a chunk.
+  unsigned long ids = bytes / 2 + 1;
+  if(ids > INTERN_MAX_IDS){
+    ids = INTERN_MAX_IDS;
+  }
+  if(bytes > INTERN_ARENA_SIZE){
+    bytes = INTERN_ARENA_SIZE;
+  }
+
+  records.chunkSize = INTERN_CHUNK_IDS * sizeof(InternRecord);
+  records.max = RECORD_CHUNKS;
+  arena.chunkSize = INTERN_ARENA_CHUNK;
+  arena.max = ARENA_CHUNKS;
+
+  // Chunks mapped after the worker processes are forked would only be seen by this process, so a shared table is mapped
+  // big enough for the whole input now.  Otherwise it starts with a chunk of each, and grows as names arrive.
+  growable = !shared;
+  int recordChunks = shared ? (ids + INTERN_CHUNK_IDS - 1) / INTERN_CHUNK_IDS : 1;
+  int arenaChunks = shared ? bytes / INTERN_ARENA_CHUNK + 1 : 1;
+  if(arenaChunks > ARENA_CHUNKS){
+    arenaChunks = ARENA_CHUNKS;
+  }
+
+  // Enough buckets for chains of a few names, taking the names to be more like 16 bytes long than 2.
+  numBuckets = INTERN_MIN_BUCKETS;
+  while(numBuckets < INTERN_MAX_BUCKETS && numBuckets < bytes / 16){
+    numBuckets *= 2;
+  }
+
+  buckets = malloc(numBuckets * sizeof(uint32_t));
+  if(buckets == NULL || map_chunks(&records, recordChunks) != 0 || map_chunks(&arena, arenaChunks) != 0){
+    intern_destroy();
+    return -1;
+  }
+
+  // Every bucket starts out empty, which INTERN_NONE marks the end of a chain with.
+  memset(buckets, 0xFF, numBuckets * sizeof(uint32_t));
+  for(int i = 0; i < INTERN_LOCKS; i++){
+    pthread_mutex_init(&locks[i], NULL);
+  }
+  count = 0;
+  used = 0;
+  return 0;
+}
+
+// Definition of intern method.
+uint32_t intern(const char* hostname)
+{
+  uint32_t hash = hash_hostname(hostname);
+  uint32_t bucket = hash & (numBuckets - 1);
+  pthread_mutex_t* lock = &locks[bucket % INTERN_LOCKS];
+  uint32_t id;
+
+  pthread_mutex_lock(lock);
+  for(id = buckets[bucket]; id != INTERN_NONE; id = record(id)->next){
+    if(record(id)->hash == hash && strcmp(arena_name(record(id)->offset), hostname) == 0){
+      pthread_mutex_unlock(lock);
+      return id;
+    }
+  }
+
+  // A new name: take the next ID and the next stretch of the arena, starting a new arena chunk if it doesn't fit in this
+  // one, and mapping more chunks if the table is allowed to grow.
+  size_t length = strlen(hostname) + 1;
+  pthread_mutex_lock(&allocLock);
+  unsigned long offset = used;
+  if(offset % INTERN_ARENA_CHUNK + length > INTERN_ARENA_CHUNK){
+    offset += INTERN_ARENA_CHUNK - offset % INTERN_ARENA_CHUNK;
+  }
+  if((count / INTERN_CHUNK_IDS >= (uint32_t) records.mapped && (!growable || map_chunks(&records, 1) != 0))
+     || (offset / INTERN_ARENA_CHUNK >= (unsigned long) arena.mapped && (!growable || map_chunks(&arena, 1) != 0))){
+    pthread_mutex_unlock(&allocLock);
+    pthread_mutex_unlock(lock);
+    return INTERN_NONE;
+  }
+  id = count++;
+  used = offset + length;
+  pthread_mutex_unlock(&allocLock);
+
+  InternRecord* entry = record(id);
+  memcpy(arena_name(offset), hostname, length);
+  entry->offset = offset;
+  entry->hash = hash;
+  entry->next = buckets[bucket];
+  entry->state = RESULT_NONE;
+  buckets[bucket] = id;
+  pthread_mutex_unlock(lock);
+
+  return id;
+}
+
+// Definition of intern_name method.
+const char* intern_name(uint32_t id)
+{
+  return id == INTERN_NONE ? "" : arena_name(record(id)->offset);
+}
+
+// Definition of intern_result method.
+int intern_result(uint32_t id, int* err, char* ip)
+{
+  if(id == INTERN_NONE || __atomic_load_n(&record(id)->state, __ATOMIC_ACQUIRE) != RESULT_READY){
+    return 0;
+  }
+  *err = record(id)->err;
+  memcpy(ip, record(id)->ip, INET6_ADDRSTRLEN);
+  return 1;
+}
+
+// Definition of intern_store method.
+void intern_store(uint32_t id, int err, const char* ip)
+{
+  // Two copies of a hostname can be resolved at once, before either result is known; only the first one is kept.
+  int expected = RESULT_NONE;
+  InternRecord* entry = id == INTERN_NONE ? NULL : record(id);
+  if(entry == NULL || !__atomic_compare_exchange_n(&entry->state, &expected, RESULT_WRITING, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)){
+    return;
+  }
+  entry->err = err;
+  strncpy(entry->ip, ip, INET6_ADDRSTRLEN - 1);
+  entry->ip[INET6_ADDRSTRLEN - 1] = '\0';
+  __atomic_store_n(&entry->state, RESULT_READY, __ATOMIC_RELEASE);
+}
+
+// Definition of intern_count method.
+long intern_count(unsigned long* bytes)
+{
+  pthread_mutex_lock(&allocLock);
+  long total = count;
+  *bytes = used;
+  pthread_mutex_unlock(&allocLock);
+  return total;
+}
+
+// Definition of intern_destroy method.
+void intern_destroy()
+{
+  unmap_chunks(&records);
+  unmap_chunks(&arena);
+  free(buckets);
+  buckets = NULL;
+}
@@ -0,0 +1,100 @@
+/*
+ *  CSCI-3753 Design and Analysis of Operating Systems, PA3 Bounded Buffer Problem - intern header file.
+ *
+ *  Hostnames are normalized (lowercased, trimmed, trailing dot removed) and then interned: every distinct hostname is
+ *  stored exactly once, and everything after the normalize stage refers to it by a 32-bit ID instead of carrying its own
+ *  copy.  Each ID also has room for the hostname's lookup result, so a hostname only ever needs to be resolved once.
+ *
+ *  The names and results live in shared memory mapped before any worker process is forked, so resolvers in worker
+ *  processes can read names interned long after they were forked.  Only the main process ever interns new names: the
+ *  index from names to IDs is private to it, and is split into groups of buckets, each with its own lock.  A name and
+ *  its ID are written before the ID is handed to another thread through a buffer, whose lock makes them visible there.
+ */
+
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <stdint.h>
+#include <netinet/in.h>
+
+// The ID given when a name can't be interned because the table is full.
+#define INTERN_NONE UINT32_MAX
+
+// Limits of the table.  Its records and names are mapped in chunks: as many as the input could need up front when the
+// table is shared with worker processes, or one at a time as names arrive otherwise.
+#define INTERN_MAX_IDS (1 << 24)
+#define INTERN_ARENA_SIZE (1UL << 30)
+#define INTERN_CHUNK_IDS (1 << 14)
+#define INTERN_ARENA_CHUNK (1UL << 20)
+#define INTERN_MIN_BUCKETS (1 << 10)
+#define INTERN_MAX_BUCKETS (1 << 20)
+#define INTERN_LOCKS 256
+
+// How much input to size the table for when a file's size isn't known, as with a pipe.
+#define INTERN_UNSIZED_INPUT (16UL << 20)
+
+// Longest valid hostname and label, in characters (RFC 1035, without the trailing dot).
+#define MAX_HOSTNAME_LENGTH 253
+#define MAX_LABEL_LENGTH 63
+
+/*
+ *  Prototype of normalize_hostname method.
+ *  This method normalizes a hostname in place: surrounding whitespace and one trailing dot are removed, and it is
+ *  lowercased.  It then checks that the hostname is no longer than MAX_HOSTNAME_LENGTH and that every label is between 1
+ *  and MAX_LABEL_LENGTH characters.
+ *  Params:  the hostname.
+ *  Returns 0 if the normalized hostname is valid, -1 if it isn't (it is normalized either way).
+ */
+int normalize_hostname(char* hostname);
+
+/*
+ *  Prototype of intern_init method.
+ *  This method maps the table.  It must be called before any worker process is forked.
+ *  Params:  the most bytes of input the run can read, and whether the table is shared with worker processes.  A shared
+ *  table is mapped big enough for that much input and never grows; a private one starts small and grows as needed.
+ *  Returns 0 on success, -1 on failure.
+ */
+int intern_init(unsigned long bytes, int shared);
+
+/*
+ *  Prototype of intern method.
+ *  This method finds the ID of a hostname, adding it to the table if it isn't there yet.  Only the main process may call it.
+ *  Params:  the normalized hostname.
+ *  Returns its ID, or INTERN_NONE if the table is full.
+ */
+uint32_t intern(const char* hostname);
+
+/*
+ *  Prototype of intern_name method.
+ *  Returns the hostname with the given ID, or an empty string for INTERN_NONE.
+ */
+const char* intern_name(uint32_t id);
+
+/*
+ *  Prototype of intern_result method.
+ *  This method looks up the result stored for a hostname.
+ *  Params:  the hostname's ID, and where to store its lookup result and ip address.
+ *  Returns 1 if a result was stored, 0 otherwise.
+ */
+int intern_result(uint32_t id, int* err, char* ip);
+
+/*
+ *  Prototype of intern_store method.
+ *  This method stores a hostname's lookup result, unless one already has been.  It may be called from any process.
+ *  Params:  the hostname's ID, its lookup result and its ip address.
+ */
+void intern_store(uint32_t id, int err, const char* ip);
+
+/*
+ *  Prototype of intern_count method.
+ *  Returns the number of distinct hostnames interned, and stores the number of bytes their names take up.
+ */
+long intern_count(unsigned long* bytes);
+
+/*
+ *  Prototype of intern_destroy method.
+ *  This method unmaps the table.
+ */
+void intern_destroy();
+
+#endif
@@ -1,5 +1,9 @@
 #include "multi-lookup.h"
 
+// Private to each worker process: where it keeps the requests it holds, and the lock its threads take them under.
+static WorkerHeld* workerHeld;
+static pthread_mutex_t heldLock = PTHREAD_MUTEX_INITIALIZER;
+
 /*
  * Main entry point.
  */
@@ -9,9 +13,19 @@ int main(int argc, char* argv[])
   struct timeval start, end;
   gettimeofday(&start, NULL);
 
+  // Parse the optional flags, then shift argv so the positional arguments keep their usual indices.
+  Options opts;
+  int first = parse_options(argc, argv, &opts);
+  if(first < 0){
+    printf("%s\n", USAGE);
+    exit(1);
+  }
+  argc -= first - 1;
+  argv += first - 1;
+
   // Print usage error if there are too few cmd args.
   if (argc < 5){
-    printf("%s\n", "Usage: ./multi-lookup <# requesters> <# resolvers> <requester log> <resolver log> [<data file> ...]");
+    printf("%s\n", USAGE);
     exit(1);
   }
 
@@ -22,7 +36,7 @@ int main(int argc, char* argv[])
   // Verify that the user requested a valid integer number of requester threads.
   err = sscanf(argv[1], "%d", &requesters);
   if(err != 1){
-    printf("%s\n", "Usage: ./multi-lookup <# requesters> <# resolvers> <requester log> <resolver log> [<data file> ...]");
+    printf("%s\n", USAGE);
     exit(1);
   }
 
@@ -35,7 +49,7 @@ int main(int argc, char* argv[])
   // Verify that the user requested a valid integer number of resolver threads.
   err = sscanf(argv[2], "%d", &resolvers);
   if(err != 1){
-    printf("%s\n", "Usage: ./multi-lookup <# requesters> <# resolvers> <requester log> <resolver log> [<data file> ...]");
+    printf("%s\n", USAGE);
     exit(1);
   }
 
@@ -51,26 +65,97 @@ int main(int argc, char* argv[])
     exit(0);
   }
 
-  // If too many input files are passed into multi-lookup, print error to stderr and terminate.
+  // Worker processes each run the full number of resolver threads, so only a modest number of them makes sense.
+  if(opts.workerProcesses < 0 || opts.workerProcesses > MAX_WORKER_PROCESSES){
+    fprintf(stderr, "Argument out of range! There must be no less than 0 and no more than %d worker processes!\n", MAX_WORKER_PROCESSES);
+    exit(1);
+  }
+
+  // Checkpoints track progress through the resolvers' own memory, so they can't follow resolvers in other processes.
+  if(opts.checkpoint != NULL && opts.workerProcesses > 0){
+    fprintf(stderr, "ERROR: --checkpoint cannot be combined with --worker-processes!\n");
+    exit(1);
+  }
+  // Likewise the reorder buffer only sees lines resolved in this process.
+  if(opts.ordered > 0 && opts.workerProcesses > 0){
+    fprintf(stderr, "ERROR: --ordered cannot be combined with --worker-processes!\n");
+    exit(1);
+  }
+  if(opts.resume && opts.checkpoint == NULL){
+    fprintf(stderr, "ERROR: --resume needs --checkpoint to name the checkpoint file!\n");
+    exit(1);
+  }
+
+  // With a DNS server given, resolvers use the native client in util.c to talk to it instead of getaddrinfo.
+  DnsServer dnsServer;
+  if(opts.dnsServer != NULL && dns_parse_server(opts.dnsServer, &dnsServer) != UTIL_SUCCESS){
+    fprintf(stderr, "ERROR: --dns-server must be an IP address, optionally followed by :PORT!\n");
+    exit(1);
+  }
+
+  // If too many input files are passed into multi-lookup, print error to stderr and terminate.  Larger jobs go in a manifest or directory.
   if(totalFiles >= MAX_INPUT_FILES){
-    fprintf(stderr, "ERROR: Too many input files were passed into multi-lookup through the command-line terminal!");
+    fprintf(stderr, "ERROR: Too many input files were passed into multi-lookup through the command-line terminal!  Use --manifest or --input-dir instead.\n");
     exit(1);
   }
   
   char* requesterLog = argv[3];
   char* resolverLog = argv[4];
 
+  // Gather the input files from the command line, the manifest and the input directory.
+  char** inputNames;
+  totalFiles = collect_inputs(totalFiles, argv + 5, opts.manifest, opts.inputDir, &inputNames);
+  if(totalFiles < 0){
+    exit(1);
+  }
+
   // Generate the list of input data files.
   FileList* inData = create_file_list(totalFiles);
-  err = open_files(totalFiles, inData, argv);
+  err = open_files(totalFiles, inData, inputNames, opts.maxOpenFiles, opts.readAhead);
 
   if(err != 0){
     printf("ERROR: Failed to initialize input files struct!\n");
     exit(1);
   }
   
-  //Initialize the shared array
-  err = init();
+  if(opts.trace != NULL){
+    trace_init(opts.trace, opts.traceSample);
+  }
+
+  // Work out where requester and resolver threads should run.
+  cpu_set_t reqSet, resSet, mainSet, initSet;
+  cpu_set_t* reqCpus;
+  cpu_set_t* resCpus;
+  err = build_cpu_sets(&opts, &reqSet, &resSet, &reqCpus, &resCpus);
+  if(err != 0){
+    fprintf(stderr, "ERROR: Invalid CPU list!  Lists look like 0-3,8,10-11.\n");
+    free(inData);
+    exit(1);
+  }
+
+  // If any threads are pinned, briefly run main on their CPUs so the shared array is allocated on their NUMA node.
+  int pinned = reqCpus != NULL || resCpus != NULL;
+  if(pinned){
+    CPU_ZERO(&initSet);
+    if(reqCpus != NULL){
+      CPU_OR(&initSet, &initSet, reqCpus);
+    }
+    if(resCpus != NULL){
+      CPU_OR(&initSet, &initSet, resCpus);
+    }
+    if(pthread_getaffinity_np(pthread_self(), sizeof(mainSet), &mainSet) != 0 || pin_current_thread(&initSet) != 0){
+      fprintf(stderr, "ERROR: Failed to run on the requested CPUs!\n");
+      free(inData);
+      exit(1);
+    }
+  }
+
+  //Initialize the shared array, in shared memory if the resolvers will run in their own processes.
+  if(opts.workerProcesses > 0){
+    err = init_shared();
+  }else{
+    err = init();
+  }
 
   // Verify that the shared array initialized properly.
   if(err != 0){
@@ -79,11 +164,66 @@ int main(int argc, char* argv[])
     exit(1);
   }
 
+  // Set up the pipeline, on the same CPUs as the shared array.  Its format and write buffers must be shared with the
+  // worker processes, if there are any.
+  int stageThreads[NUM_STAGES] = {requesters, opts.normalizers, resolvers, opts.formatters, opts.writers};
+  if(opts.workerProcesses > 0){
+    stageThreads[STAGE_RESOLVE] = resolvers * opts.workerProcesses;
+  }
+  // The intern table is sized from the input: no file holds more hostname text than its size, plus a terminator for a
+  // last line without a newline.
+  unsigned long inputBytes = 0;
+  for(int i = 0; i < totalFiles; i++){
+    inputBytes += inData->list[i].size >= 0 ? (unsigned long) inData->list[i].size + 1 : INTERN_UNSIZED_INPUT;
+  }
+  Pipeline* pipeline = pipeline_create(stageThreads, opts.workerProcesses > 0, inputBytes);
+  if(pipeline == NULL){
+    destroy();
+    free(inData);
+    exit(1);
+  }
+
+  if(pinned && pin_current_thread(&mainSet) != 0){
+    fprintf(stderr, "ERROR: Failed to move main back to its own CPUs!\n");
+    pipeline_destroy(pipeline);
+    destroy();
+    free(inData);
+    exit(1);
+  }
+
+  // When resuming, move every input file's progress forward to the checkpoint, and keep what the logs already hold.
+  long keepResults = -1;
+  long keepServiced = -1;
+  if(opts.resume){
+    err = checkpoint_load(opts.checkpoint, inData, &keepResults, &keepServiced);
+    if(err < 0){
+      pipeline_destroy(pipeline);
+      destroy();
+      pthread_mutex_destroy(&inData->lock);
+      free(inData);
+      exit(1);
+    }
+    if(err > 0){
+      printf("%s%s%s\n", "No checkpoint file ", opts.checkpoint, " found, starting from the beginning.");
+    }
+  }
+
+  // Files are handed out largest first, by what the checkpoint leaves of them, unless output has to follow input order,
+  // which is easiest to keep if they are read in it.
+  if(order_files(inData, opts.ordered == 0) != 0){
+    pipeline_destroy(pipeline);
+    destroy();
+    pthread_mutex_destroy(&inData->lock);
+    free(inData);
+    exit(1);
+  }
+
   OutFile resultsFile;
-  err = open_results(&resultsFile, requesterLog);
+  err = open_results(&resultsFile, requesterLog, keepResults);
 
   // Verify that the results file mutex lock initialized properly.
   if(err != 0){
+    pipeline_destroy(pipeline);
     destroy();
     pthread_mutex_destroy(&inData->lock);
     free(inData);
@@ -92,10 +232,11 @@ int main(int argc, char* argv[])
 
   // Generate the serviced file struct.
   OutFile servicedFile;
-  open_serviced(&servicedFile, resolverLog);
+  err = open_serviced(&servicedFile, resolverLog, keepServiced);
 
   // Verify that the serviced file mutex lock initialized properly.
   if(err != 0){
+    pipeline_destroy(pipeline);
     destroy();
     pthread_mutex_destroy(&inData->lock);
     free(inData);
@@ -107,6 +248,7 @@ int main(int argc, char* argv[])
   // If memory cannot be allocated for requester thread ids, free all allocated memory and exit in error state.
   if(reqThreads == NULL){
     printf("%s\n", "ERROR: Failed to allocate memory for requester threads!");
+    pipeline_destroy(pipeline);
     destroy();
     pthread_mutex_destroy(&inData->lock);
     pthread_mutex_destroy(&resultsFile.lock);
@@ -120,6 +262,7 @@ int main(int argc, char* argv[])
   // If memory cannot be allocated for resolver thread ids, free all allocated memory and exit in error state
   if(resThreads == NULL){
     printf("%s\n", "ERROR: Failed to allocate memory for resolver threads!");
+    pipeline_destroy(pipeline);
     destroy();
     pthread_mutex_destroy(&inData->lock);
     pthread_mutex_destroy(&resultsFile.lock);
@@ -130,22 +273,117 @@ int main(int argc, char* argv[])
   }
 
   // Generate args to be passed into requester/resolver threads.
-  struct RequesterArgs* reqArgs = malloc(sizeof(inData) + sizeof(resultsFile));
+  struct RequesterArgs* reqArgs = malloc(sizeof(*reqArgs));
   reqArgs->data = inData;
   reqArgs->results = resultsFile;
+  reqArgs->checkpoint = NULL;
+  reqArgs->reorder = NULL;
 
-  struct ResolverArgs* resArgs = malloc(sizeof(inData) + sizeof(servicedFile));
+  struct ResolverArgs* resArgs = malloc(sizeof(*resArgs));
   resArgs->data = inData;
   resArgs->serviced = servicedFile;
+  resArgs->checkpoint = NULL;
+  resArgs->limiter = NULL;
+  resArgs->reorder = NULL;
+  resArgs->dnsServer = opts.dnsServer != NULL ? &dnsServer : NULL;
+  reqArgs->next = resArgs;
+
+  resArgs->pipeline = pipeline;
+
+  // In ordered mode, resolvers hand their lines to a reorder buffer which writes them in input order.
+  Reorder reorder;
+  if(opts.ordered > 0 && reorder_init(&reorder, totalFiles, opts.ordered, write_serviced, (void *) resArgs) == 0){
+    reqArgs->reorder = &reorder;
+    resArgs->reorder = &reorder;
+  }
+
+  // The rate limiter has to be shared with the worker processes, if there are any, so it is created before they are.
+  if(opts.rate > 0){
+    resArgs->limiter = limiter_create(opts.rate, opts.maxRate, opts.workerProcesses > 0);
+    if(resArgs->limiter == NULL){
+      printf("%s\n", "ERROR: Failed to create the rate limiter!");
+    }
+  }
+
+  // Checkpointing works on the logs exactly as the threads see them, locks included.
+  Checkpoint checkpoint;
+  if(opts.checkpoint != NULL && checkpoint_init(&checkpoint, opts.checkpoint, opts.checkpointInterval, inData, &reqArgs->results, &resArgs->serviced) == 0){
+    reqArgs->checkpoint = &checkpoint;
+    resArgs->checkpoint = &checkpoint;
+  }
   
-  // Generate requester threads and resolver threads.
-  generate_requesters(requesters, reqThreads, reqArgs);
-  generate_resolvers(resolvers, resThreads, resArgs);
-  err = join_threads(requesters, reqThreads);
+  // In worker process mode, start the workers before any threads exist, and a supervisor thread to keep them running.
+  struct WorkerArgs workers;
+  pthread_t supervisorThread;
+  if(opts.workerProcesses > 0){
+    workers.numWorkers = opts.workerProcesses;
+    workers.numResolvers = resolvers;
+    workers.resolverArgs = resArgs;
+    workers.cpus = resCpus;
+    workers.crashed = 0;
+    workers.requeued = NULL;
+    workers.numRequeued = 0;
+    workers.totalRequeued = 0;
+    workers.lost = 0;
+
+    // What each worker holds has to be readable after it dies, so it is kept in memory shared with the workers.
+    workers.held = mmap(NULL, workers.numWorkers * sizeof(WorkerHeld), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if(workers.held == MAP_FAILED){
+      printf("%s\n", "ERROR: Failed to map the worker processes' held requests!");
+      pipeline_destroy(pipeline);
+      destroy();
+      exit(1);
+    }
+
+    // Every worker appends whole lines to the same serviced file, so it must be flushed a line at a time.
+    setvbuf(servicedFile.fd, NULL, _IOLBF, 0);
+    for(int i = 0; i < workers.numWorkers; i++){
+      workers.pids[i] = spawn_worker(&workers, i);
+    }
+    pthread_create(&supervisorThread, NULL, supervisor, (void *) &workers);
+  }
+
+  // Generate the threads of every stage, from the last stage back to the first.  Requesters and normalizers are kept on
+  // the requesters' CPUs; resolvers, formatters and writers on the resolvers'.  If a stage can't be started, no earlier
+  // stage is, and the stages already running are shut down below just as at the end of a run, since their buffers stay
+  // empty.  Only the threads that were created are joined.
+  pthread_t normThreads[MAX_STAGE_THREADS], formatThreads[MAX_STAGE_THREADS], writeThreads[MAX_STAGE_THREADS];
+  int started[NUM_STAGES] = {0};
+  started[STAGE_WRITE] = generate_stage(opts.writers, writeThreads, writer, resArgs, "writer", resCpus);
+  int failed = started[STAGE_WRITE] < opts.writers;
+  if(!failed){
+    started[STAGE_FORMAT] = generate_stage(opts.formatters, formatThreads, formatter, resArgs, "formatter", resCpus);
+    failed = started[STAGE_FORMAT] < opts.formatters;
+  }
+  if(!failed && opts.workerProcesses == 0){
+    started[STAGE_RESOLVE] = generate_resolvers(resolvers, resThreads, resArgs, resCpus);
+    failed = started[STAGE_RESOLVE] < resolvers;
+  }
+  if(!failed){
+    started[STAGE_NORMALIZE] = generate_stage(opts.normalizers, normThreads, normalizer, resArgs, "normalizer", reqCpus);
+    failed = started[STAGE_NORMALIZE] < opts.normalizers;
+  }
+  // Requesters that did start share out every input file between them, so they finish the input even if others didn't.
+  if(!failed){
+    started[STAGE_READ] = generate_requesters(requesters, reqThreads, reqArgs, reqCpus);
+    failed = started[STAGE_READ] < requesters;
+  }
+  if(failed){
+    fprintf(stderr, "ERROR: Failed to start every thread!  Shutting down the threads that did start.\n");
+  }
+  err = join_threads(started[STAGE_READ], reqThreads);
+
+  // Each stage is shut down once every thread feeding it has finished: its buffer is closed, so its threads exit as soon
+  // as they have drained it.
+  if(err == 0){
+    RawQueue_close(resArgs->pipeline->normalizeQueue);
+    err = join_threads(started[STAGE_NORMALIZE], normThreads);
+  }
 
   // If requester threads could not be joined, free all allocated memory and exit in error state.
   if(err != 0){
     printf("%s\n", "Failed joining the requester threads.  Terminating multi-lookup!");
+    pipeline_destroy(pipeline);
     destroy();
     pthread_mutex_destroy(&inData->lock);
     pthread_mutex_destroy(&resultsFile.lock);
@@ -156,11 +394,32 @@ int main(int argc, char* argv[])
     exit(1);
   }
 
-  err = join_threads(resolvers, resThreads);
+  // Every hostname has been through the normalize stage, so let the resolvers exit once the shared array is drained.
+  ts_close();
+
+  if(opts.workerProcesses > 0){
+    pthread_join(supervisorThread, NULL);
+    if(workers.crashed > 0 || workers.lost > 0){
+      fprintf(stderr, "WARNING: %d worker process(es) crashed; %ld hostnames they were resolving were handed to their replacements, and %ld given up on.\n", workers.crashed, workers.totalRequeued, workers.lost);
+    }
+    munmap(workers.held, workers.numWorkers * sizeof(WorkerHeld));
+  }
+
+  err = join_threads(started[STAGE_RESOLVE], resThreads);
+
+  if(err == 0){
+    ResultQueue_close(resArgs->pipeline->formatQueue);
+    err = join_threads(started[STAGE_FORMAT], formatThreads);
+  }
+  if(err == 0){
+    LineQueue_close(resArgs->pipeline->writeQueue);
+    err = join_threads(started[STAGE_WRITE], writeThreads);
+  }
 
   // If resolver threads could not be joined, free all allocated memory and exit in error state.
   if(err != 0){
     printf("%s\n", "Failed joining the resolver threads.  Terminating multi-lookup!");
+    pipeline_destroy(pipeline);
     destroy();
     pthread_mutex_destroy(&inData->lock);
     pthread_mutex_destroy(&resultsFile.lock);
@@ -171,6 +430,21 @@ int main(int argc, char* argv[])
     exit(1);
   }
 
+  // Every writer has finished, so anything the reorder buffer still holds can only be written out of order.
+  long unordered = -1;
+  if(resArgs->reorder != NULL){
+    unordered = reorder_finish(&reorder);
+  }
+
+  // Every thread has been joined, so the trace rings can be read.
+  trace_export(0);
+
+  // Record the finished run, so that resuming it does nothing.
+  if(reqArgs->checkpoint != NULL){
+    checkpoint_write(&checkpoint);
+    checkpoint_destroy(&checkpoint);
+  }
+
   // Close serviced/results files.
   fclose(servicedFile.fd);
   fclose(resultsFile.fd);
@@ -181,61 +455,115 @@ int main(int argc, char* argv[])
   pthread_mutex_destroy(&servicedFile.lock);
   for(int i = 0; i < totalFiles; i++){
     pthread_mutex_destroy(&inData->list[i].lock);
-    if(inData->list[i].fd != NULL){
-      fclose(inData->list[i].fd);
-    }
+    pthread_cond_destroy(&inData->list[i].progress);
   }
+  sem_destroy(&inData->budget);
+  free(inData->order);
   free(inData);
+  free_inputs(totalFiles, inputNames);
   free(reqThreads);
   free(resThreads);
-  free(reqArgs);
-  free(resArgs);
   destroy();
 
   // Get the end time from gettimeofday function and compute total runtime.
   gettimeofday(&end, NULL);
   double runtime = (double)(end.tv_usec - start.tv_usec)/1000000 + (double)(end.tv_sec - start.tv_sec);
 
-  // Print total runtime to stdout.
+  // Print total runtime to stdout, and how hard the upstream pushed back if we were limiting the rate.
   printf("%s%f%s\n", "Total runtime of multi-lookup: ", runtime, " seconds.");
-  return 0;
+  if(unordered >= 0){
+    printf("%s%ld%s\n", "Ordered output: ", unordered, " serviced lines were written out of input order.");
+  }
+  if(resArgs->limiter != NULL){
+    limiter_summary(resArgs->limiter, stdout);
+    limiter_destroy(resArgs->limiter);
+  }
+  pipeline_report(resArgs->pipeline, stdout, runtime);
+  pipeline_destroy(resArgs->pipeline);
+  free(reqArgs);
+  free(resArgs);
+  return failed ? 1 : 0;
 }
 
 // Definition of generate_requesters method of multi-lookup.
-int generate_requesters(int numRequesters, pthread_t* tids, struct RequesterArgs* args)
+int generate_requesters(int numRequesters, pthread_t* tids, struct RequesterArgs* args, cpu_set_t* cpus)
 {
-  // Generate the specified number of requester threads.
-  for(int i = 0; i < numRequesters; i++)
+  return generate_stage(numRequesters, tids, requester, (void *) args, "requester", cpus);
+}
+
+// Definition of generate_resolvers method of multi-lookup.
+int generate_resolvers(int numResolvers, pthread_t* tids, struct ResolverArgs* args, cpu_set_t* cpus)
+{
+  return generate_stage(numResolvers, tids, resolver, (void *) args, "resolver", cpus);
+}
+
+// Definition of generate_stage method of multi-lookup.
+int generate_stage(int numThreads, pthread_t* tids, void* (*routine)(void *), void* args, const char* name, cpu_set_t* cpus)
+{
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+
+  // Pin the threads to the requested CPUs, if any.
+  if(cpus != NULL && pthread_attr_setaffinity_np(&attr, sizeof(*cpus), cpus) != 0){
+    printf("%s\n", "ERROR: Failed to pin threads to the requested CPUs!");
+    pthread_attr_destroy(&attr);
+    return 0;
+  }
+
+  // Generate the specified number of threads.
+  for(int i = 0; i < numThreads; i++)
   {
     int err;
-    err = pthread_create(&tids[i], NULL, requester, (void *) args);
+    err = pthread_create(&tids[i], &attr, routine, args);
 
     // Confirm that there were no issues creating each thread.
     if(err != 0)
     {
-      printf("%s%d%s\n", "Something went terribly wrong creating the ", i, "th requester thread. Whoopsie.");
-      return -1;
+      printf("%s%d%s%s%s\n", "Something went terribly wrong creating the ", i, "th ", name, " thread. Whoopsie.");
+      pthread_attr_destroy(&attr);
+      return i;
     }
   }
 
-  return 0;
+  pthread_attr_destroy(&attr);
+  return numThreads;
 }
 
-// Definition of generate_resolvers method of multi-lookup.
-int generate_resolvers(int numResolvers, pthread_t* tids, struct ResolverArgs* args)
+// Definition of build_cpu_sets method of multi-lookup.
+int build_cpu_sets(Options* opts, cpu_set_t* reqSet, cpu_set_t* resSet, cpu_set_t** reqCpus, cpu_set_t** resCpus)
 {
-  // Generate the specified number of resolver threads.
-  for(int i=0; i < numResolvers; i++)
-  {
-    int err;
-    err = pthread_create(&tids[i], NULL, resolver, (void *) args);
+  *reqCpus = NULL;
+  *resCpus = NULL;
 
-    // Confirm that there were no issues creating each thread.
-    if(err != 0)
-    {
-      printf("%s%d%s\n", "Something went terribly wrong creating the ", i, "th resolver thread. Whoopsie.");
+  // Explicit lists always win.
+  if(opts->requesterCpus != NULL){
+    if(parse_cpu_list(opts->requesterCpus, reqSet) != 0){
       return -1;
     }
+    *reqCpus = reqSet;
+  }
+  if(opts->resolverCpus != NULL){
+    if(parse_cpu_list(opts->resolverCpus, resSet) != 0){
+      return -1;
+    }
+    *resCpus = resSet;
+  }
+
+  // In auto mode, keep every class without a list on the node main is running on.
+  if(opts->numaAuto){
+    cpu_set_t nodeSet;
+    if(numa_node_cpus(numa_current_node(), &nodeSet) != 0){
+      // No NUMA information, so there is nothing to keep local.
+      return 0;
+    }
+    if(*reqCpus == NULL){
+      *reqSet = nodeSet;
+      *reqCpus = reqSet;
+    }
+    if(*resCpus == NULL){
+      *resSet = nodeSet;
+      *resCpus = resSet;
+    }
   }
 
   return 0;
@@ -259,119 +587,684 @@ int join_threads(int numThreads, pthread_t* tids){
   return 0;
 }
 
+// Definition of spawn_worker method of multi-lookup.
+pid_t spawn_worker(struct WorkerArgs* args, int slot)
+{
+  // Make sure the child doesn't inherit (and later repeat) anything still sitting in stdout's buffer.
+  fflush(stdout);
+  memset(&args->held[slot], 0, sizeof(WorkerHeld));
+  memcpy(args->held[slot].pending, args->requeued, args->numRequeued * sizeof(Request));
+  args->held[slot].numPending = args->numRequeued;
+  pid_t pid = fork();
+  if(pid != 0){
+    if(pid < 0){
+      printf("%s\n", "ERROR: Failed to fork a worker process!");
+    }
+    return pid;
+  }
+
+  // Child: run the resolvers against the shared array, then leave without flushing the parent's other streams.
+  trace_forget();
+  workerHeld = &args->held[slot];
+  pthread_t tids[MAX_RESOLVER_THREADS];
+  int started = generate_resolvers(args->numResolvers, tids, args->resolverArgs, args->cpus);
+  int err = join_threads(started, tids);
+  if(started < args->numResolvers){
+    err = -1;
+  }
+  fflush(args->resolverArgs->serviced.fd);
+  trace_export(1);
+  fflush(stdout);
+  _exit(err == 0 ? 0 : 1);
+}
+
+// Definition of supervisor thread.
+void* supervisor(void* args)
+{
+  struct WorkerArgs* workers = (struct WorkerArgs *) args;
+  Request* held = malloc(MAX_PENDING * sizeof(Request));
+  int running = 0;
+
+  for(int i = 0; i < workers->numWorkers; i++){
+    if(workers->pids[i] > 0){
+      running++;
+    }
+  }
+
+  while(running > 0){
+    int status;
+    pid_t pid = waitpid(-1, &status, 0);
+    if(pid < 0){
+      break;
+    }
+
+    // Find which worker exited; anything else we might be waiting on is none of our business.
+    int slot = -1;
+    for(int i = 0; i < workers->numWorkers; i++){
+      if(workers->pids[i] == pid){
+	slot = i;
+      }
+    }
+    if(slot < 0){
+      continue;
+    }
+    running--;
+    workers->pids[slot] = -1;
+
+    if(WIFEXITED(status) && WEXITSTATUS(status) == 0){
+      continue;
+    }
+
+    // The worker crashed.  Gather up the requests it was holding: those it had yet to take as they were, and those it had
+    // taken counting one more death against them, giving up on any that have now killed too many workers.
+    workers->crashed++;
+    fprintf(stderr, "WARNING: Worker process %d died unexpectedly!\n", pid);
+    WorkerHeld* dead = &workers->held[slot];
+    int numHeld = 0;
+    int overflow = 0;
+    for(int i = 0; held != NULL && i < dead->numPending; i++){
+      if(numHeld == MAX_PENDING){
+	give_up(workers, &dead->pending[i]);
+	overflow++;
+	continue;
+      }
+      held[numHeld++] = dead->pending[i];
+    }
+    for(int row = 0; held != NULL && row < MAX_RESOLVER_THREADS; row++){
+      for(int i = 0; i < DNS_WINDOW; i++){
+	if(!dead->used[row][i]){
+	  continue;
+	}
+	Request* request = &dead->requests[row][i];
+	if(++request->requeued > MAX_REQUEUES){
+	  fprintf(stderr, "ERROR: Giving up on %s after %d worker processes died resolving it!\n", intern_name(request->host), request->requeued);
+	  give_up(workers, request);
+	  continue;
+	}
+	if(numHeld == MAX_PENDING){
+	  give_up(workers, request);
+	  overflow++;
+	  continue;
+	}
+	held[numHeld++] = *request;
+      }
+    }
+    if(overflow > 0){
+      fprintf(stderr, "ERROR: Gave up on %d hostnames worker process %d held, more than its replacement can take!\n", overflow, pid);
+    }
+
+    // Replace the worker as long as there could still be hostnames left for it to resolve.  The replacement gets its own
+    // copy of the held requests when it is forked, and resolves them first.
+    if(numHeld > 0 || !is_closed() || get_num_elements() > 0){
+      workers->requeued = held;
+      workers->numRequeued = numHeld;
+      workers->pids[slot] = spawn_worker(workers, slot);
+      workers->requeued = NULL;
+      workers->numRequeued = 0;
+      if(workers->pids[slot] > 0){
+	running++;
+	workers->totalRequeued += numHeld;
+      }else{
+	for(int i = 0; i < numHeld; i++){
+	  give_up(workers, &held[i]);
+	}
+      }
+    }
+  }
+  free(held);
+
+  // With no worker left, whatever is still in the shared array, or is yet to be put in it, would never be read.
+  Request request;
+  if(running == 0 && ts_read(&request) == 0){
+    long before = workers->lost;
+    do{
+      give_up(workers, &request);
+    }while(ts_read(&request) == 0);
+    fprintf(stderr, "ERROR: No worker process was left to resolve %ld hostnames!\n", workers->lost - before);
+  }
+  return 0;
+}
+
+// Definition of give_up method of multi-lookup.
+void give_up(struct WorkerArgs* workers, Request* request)
+{
+  Result result;
+  result.request = *request;
+  result.err = UTIL_FAILURE;
+  result.ip[0] = '\0';
+  pass_result(workers->resolverArgs, &result);
+  workers->lost++;
+}
+
+// Definition of take_request method of multi-lookup.
+int take_request(Request* request, int block, int row, int slot)
+{
+  if(row < 0){
+    return block ? ts_read(request) : ts_try_read(request);
+  }
+
+  // A suspect is recorded as held before it stops being pending, so that if this process dies in between, it is at
+  // worst handed on twice rather than lost.
+  pthread_mutex_lock(&heldLock);
+  if(workerHeld->numPending > 0 && workerHeld->suspects == 0){
+    *request = workerHeld->pending[workerHeld->numPending - 1];
+    workerHeld->requests[row][slot] = *request;
+    __atomic_store_n(&workerHeld->used[row][slot], HELD_SUSPECT, __ATOMIC_RELEASE);
+    workerHeld->suspects++;
+    __atomic_store_n(&workerHeld->numPending, workerHeld->numPending - 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&heldLock);
+    return 0;
+  }
+  pthread_mutex_unlock(&heldLock);
+
+  if((block ? ts_read(request) : ts_try_read(request)) != 0){
+    return -1;
+  }
+  workerHeld->requests[row][slot] = *request;
+  __atomic_store_n(&workerHeld->used[row][slot], HELD_FRESH, __ATOMIC_RELEASE);
+  return 0;
+}
+
+// Definition of hold_row method of multi-lookup.
+int hold_row()
+{
+  if(workerHeld == NULL){
+    return -1;
+  }
+  return __atomic_fetch_add(&workerHeld->rows, 1, __ATOMIC_RELAXED);
+}
+
+// Definition of release_request method of multi-lookup.
+void release_request(int row, int slot)
+{
+  if(row < 0){
+    return;
+  }
+  if(workerHeld->used[row][slot] == HELD_SUSPECT){
+    pthread_mutex_lock(&heldLock);
+    workerHeld->suspects--;
+    pthread_mutex_unlock(&heldLock);
+  }
+  __atomic_store_n(&workerHeld->used[row][slot], HELD_NONE, __ATOMIC_RELEASE);
+}
+
 // Definition of requester thread.
 void* requester(void* args)
 {
   int filesProcessed = 0;
+  long bytesProcessed = 0;
   struct RequesterArgs* reqArgs = (struct RequesterArgs *) args;
   FileList* files = reqArgs->data;
-  char* hostname;
-  hostname = (char *) malloc(sizeof(char) * MAX_NAME_LENGTH);
+  Checkpoint* checkpoint = reqArgs->checkpoint;
+  RawRequest* raw;
+  raw = (RawRequest *) malloc(sizeof(RawRequest));
   char newline[2] = "\n\0";
+  trace_thread("requester");
 
   // Exit thread if memory failed to allocate for the hostnames.
-  if(hostname == NULL){
+  if(raw == NULL){
     printf("%s%lu%s\n", "ERROR: Failed to allocate memory for hostname in thread: ", pthread_self(), "!");
     pthread_exit(PTHREAD_CANCELED);
   }
+  Request* request = &raw->request;
 
   while(1)
   {
-    FILE* fd;
+    FILE* fd = NULL;
+    Input* input;
+    int index;
     pthread_t tid = pthread_self();
 
-    // Lock file list
-    pthread_mutex_lock(&files->lock);
-
-    // Find the next valid input data file, if there are none, terminate thread, and print the number of files processed.
-    if(files->current == files->total){
-      pthread_mutex_unlock(&files->lock);
-      printf("%s%lu%s%d%s\n", "Thread ", tid, " serviced ", filesProcessed, " files.");
+    // Claim the next input data file, and a descriptor to read it with; if there are none, terminate thread, and print the
+    // number of files processed.
+    index = claim_input(files);
+    if(index < 0){
+      printf("%s%lu%s%d%s%ld%s\n", "Thread ", tid, " serviced ", filesProcessed, " files (", bytesProcessed, " bytes).");
       break;
-    }else{
-      fd = files->list[files->current].fd;
-      files->current++;
-      
+    }
+    request->file = index;
+    input = &files->list[index];
+
+    // When checkpointing, a file the last run finished needs no more work, and any other picks up from its watermark.
+    int err = 0;
+    long offset = 0;
+    if(checkpoint != NULL){
+      err = checkpoint_start(input);
+      if(err < 0){
+	printf("%s%s%s\n", "ERROR: Failed to resume input file ", input->name, "!");
+      }
+      offset = input->watermark;
+    }
+
+    // Only now is the file opened, so that no more than the allowed number of input files are ever open at once.
+    if(err == 0 && open_input(files, index) == 0){
+      fd = input->fd;
+      if(offset > 0 && fseek(fd, offset, SEEK_SET) != 0){
+	printf("%s%s%s\n", "ERROR: Failed to resume input file ", input->name, "!");
+	fd = NULL;
+      }
+    }
+    if(fd == NULL){
+      close_input(files, index);
+      if(reqArgs->reorder != NULL){
+	reorder_eof(reqArgs->reorder, index, 0);
+      }
+      pthread_mutex_lock(&files->lock);
+      files->processed++;
       pthread_mutex_unlock(&files->lock);
+      continue;
     }
 
+    long seq = 0;
     while(fd != NULL)
     {
       // Retrieve the next hostname from input file, if fgets returns null, exit the loop and find the next input file.
-      char* read = fgets(hostname, MAX_NAME_LENGTH, fd);
+      long long start = trace_now();
+      char* read = fgets(raw->hostname, MAX_NAME_LENGTH, fd);
       if(read == NULL)
       {
+	if(checkpoint != NULL){
+	  checkpoint_eof(input, seq);
+	}
+	if(reqArgs->reorder != NULL){
+	  reorder_eof(reqArgs->reorder, index, seq);
+	}
+	close_input(files, index);
+	pthread_mutex_lock(&files->lock);
 	files->processed++;
+	pthread_mutex_unlock(&files->lock);
 	filesProcessed++;
+	if(input->size > 0){
+	  bytesProcessed += input->size;
+	}
 	break;
       }
 
-      //Place hostname into shared array.
-      ts_write(hostname);
+      // Note where the line came from, so its progress can be tracked.
+      request->seq = seq++;
+      request->offset = offset;
+      offset += strlen(raw->hostname);
+      request->end = offset;
+
+      // In ordered mode, don't read further ahead of the output than the reorder window can hold.
+      if(reqArgs->reorder != NULL){
+	reorder_admit(reqArgs->reorder, request->file, request->seq);
+      }
+
+      int state = LINE_NEW;
+      if(checkpoint != NULL){
+	state = checkpoint_read(input, request->seq, request->offset, request->end);
+	if(state == LINE_SERVICED){
+	  // Ordered output still has to know the line is taken care of before it can move past it.
+	  if(reqArgs->reorder != NULL){
+	    reorder_submit(reqArgs->reorder, request, NULL);
+	  }
+	  continue;
+	}
+      }
+
+      // Write hostname to results file, before it is enqueued, so that it is never resolved without being logged.
+      raw->hostname[strcspn(raw->hostname, "\n")] = '\0';
+      request->traced = trace_sampled(request->file, request->seq);
+      request->requeued = 0;
+      if(request->traced){
+	trace_event(TRACE_READ, request, raw->hostname, 0);
+      }
+      if(state == LINE_NEW){
+	pthread_mutex_lock(&reqArgs->results.lock);
+	fputs(raw->hostname, reqArgs->results.fd);
+	fputs(newline, reqArgs->results.fd);
+	if(checkpoint != NULL){
+	  checkpoint_logged(input, request->end);
+	}
+	pthread_mutex_unlock(&reqArgs->results.lock);
+      }
+
+      // Hand the hostname on to the normalize stage, which places it into the shared array.
+      pipeline_count(reqArgs->next->pipeline, STAGE_READ, 1, start);
+      pass_request(reqArgs->next, raw);
 
-      strcat(hostname, newline);
-      // Write hostname to results file
-      pthread_mutex_lock(&reqArgs->results.lock);
-      fputs(hostname, reqArgs->results.fd);
-      pthread_mutex_unlock(&reqArgs->results.lock);
+      if(checkpoint != NULL){
+	checkpoint_maybe(checkpoint);
+      }
     }   
   }
-  free(hostname);
+  free(raw);
   return 0;
 }
 
+// Definition of write_serviced method of multi-lookup.
+void write_serviced(void* args, Request* request, const char* ip, int ordered)
+{
+  struct ResolverArgs* resArgs = (struct ResolverArgs *) args;
+
+  // A line the last run already wrote has nothing left to do.
+  if(ip == NULL){
+    return;
+  }
+
+  // Build the resolution string: the hostname, then the ip address or NOT_RESOLVED, flagged if it is out of input order.
+  const char* hostname = intern_name(request->host);
+  pthread_mutex_lock(&resArgs->serviced.lock);
+  if(ordered){
+    fprintf(resArgs->serviced.fd, "%s, %s\n", hostname, ip);
+  }else{
+    fprintf(resArgs->serviced.fd, "%s, %s, OUT_OF_ORDER\n", hostname, ip);
+  }
+  if(resArgs->checkpoint != NULL){
+    checkpoint_done(&resArgs->data->list[request->file], request->seq, request->offset, request->end);
+  }
+  pthread_mutex_unlock(&resArgs->serviced.lock);
+
+  if(request->traced){
+    trace_event(TRACE_WRITTEN, request, intern_name(request->host), 0);
+  }
+}
+
+// Definition of pass_request method of multi-lookup.
+void pass_request(struct ResolverArgs* resArgs, RawRequest* raw)
+{
+  Pipeline* pipeline = resArgs->pipeline;
+  if(pipeline->threads[STAGE_NORMALIZE] > 0){
+    RawQueue_put(pipeline->normalizeQueue, raw);
+  }else{
+    normalize_request(resArgs, raw);
+  }
+}
+
+// Definition of pass_result method of multi-lookup.
+void pass_result(struct ResolverArgs* resArgs, Result* result)
+{
+  Pipeline* pipeline = resArgs->pipeline;
+  if(pipeline->threads[STAGE_FORMAT] > 0){
+    ResultQueue_put(pipeline->formatQueue, result);
+  }else{
+    format_result(resArgs, result);
+  }
+}
+
+// Definition of pass_line method of multi-lookup.
+void pass_line(struct ResolverArgs* resArgs, Line* line)
+{
+  Pipeline* pipeline = resArgs->pipeline;
+  if(pipeline->threads[STAGE_WRITE] > 0){
+    LineQueue_put(pipeline->writeQueue, line);
+  }else{
+    write_line(resArgs, line);
+  }
+}
+
+// Definition of normalize_request method of multi-lookup.
+void normalize_request(struct ResolverArgs* resArgs, RawRequest* raw)
+{
+  Pipeline* pipeline = resArgs->pipeline;
+  long long start = trace_now();
+  Request* request = &raw->request;
+  Result result;
+
+  // From here on the hostname is only carried by its ID.
+  int valid = normalize_hostname(raw->hostname);
+  request->host = intern(raw->hostname);
+  if(request->host == INTERN_NONE){
+    // The table is full.  The hostname can't be passed on by ID, so its line is written here, without a lookup; in ordered
+    // mode that is out of order, and the reorder buffer is only told the line is done.
+    fprintf(stderr, "%s%s%s\n", "ERROR: The intern table is full, so ", raw->hostname, " was not resolved!");
+    pthread_mutex_lock(&resArgs->serviced.lock);
+    fprintf(resArgs->serviced.fd, "%s, %s%s\n", raw->hostname, "NOT_RESOLVED", resArgs->reorder != NULL ? ", OUT_OF_ORDER" : "");
+    if(resArgs->checkpoint != NULL){
+      checkpoint_done(&resArgs->data->list[request->file], request->seq, request->offset, request->end);
+    }
+    pthread_mutex_unlock(&resArgs->serviced.lock);
+    if(resArgs->reorder != NULL){
+      reorder_submit(resArgs->reorder, request, NULL);
+    }
+    pipeline_count(pipeline, STAGE_NORMALIZE, 1, start);
+    return;
+  }
+
+  // A hostname which isn't valid is never looked up; a hostname whose result is already known skips the resolve stage.
+  if(valid != 0){
+    result.err = UTIL_FAILURE;
+    result.ip[0] = '\0';
+  }
+  if(valid != 0 || cache_lookup(pipeline, request->host, &result.err, result.ip)){
+    result.request = *request;
+    pipeline_count(pipeline, STAGE_NORMALIZE, 1, start);
+    pass_result(resArgs, &result);
+    return;
+  }
+  pipeline_count(pipeline, STAGE_NORMALIZE, 1, start);
+
+  //Place hostname into shared array.  The enqueue is timed from before the write, so that it always starts before a
+  //resolver can take the hostname out.
+  long long enqueueStart = request->traced ? trace_now() : 0;
+  ts_write(request);
+  if(request->traced){
+    trace_event(TRACE_ENQUEUE, request, raw->hostname, enqueueStart);
+  }
+}
+
+// Definition of format_result method of multi-lookup.
+void format_result(struct ResolverArgs* resArgs, Result* result)
+{
+  Pipeline* pipeline = resArgs->pipeline;
+  long long start = trace_now();
+  Line line;
+
+  // Remember the result, so that later copies of the hostname needn't be looked up again.
+  cache_store(result);
+
+  // The line carries the ip address if the lookup succeeded, or NOT_RESOLVED; its hostname is added when it is written.
+  line.request = result->request;
+  if(result->err == UTIL_SUCCESS){
+    memcpy(line.ip, result->ip, INET6_ADDRSTRLEN);
+  }else{
+    snprintf(line.ip, sizeof(line.ip), "%s", "NOT_RESOLVED");
+  }
+  pipeline_count(pipeline, STAGE_FORMAT, 1, start);
+
+  pass_line(resArgs, &line);
+}
+
+// Definition of write_line method of multi-lookup.
+void write_line(struct ResolverArgs* resArgs, Line* line)
+{
+  long long start = trace_now();
+
+  // Print the line to the serviced file, or pass it to the reorder buffer to be printed in input order.
+  if(resArgs->reorder != NULL){
+    reorder_submit(resArgs->reorder, &line->request, line->ip);
+  }else{
+    write_serviced(resArgs, &line->request, line->ip, 1);
+  }
+  pipeline_count(resArgs->pipeline, STAGE_WRITE, 1, start);
+}
+
+// Definition of normalizer thread.
+void* normalizer(void* args)
+{
+  struct ResolverArgs* resArgs = (struct ResolverArgs *) args;
+  RawQueue* queue = resArgs->pipeline->normalizeQueue;
+  RawRequest* raw = malloc(sizeof(RawRequest));
+  trace_thread("normalizer");
+
+  while(raw != NULL && RawQueue_get(queue, raw) == 0){
+    pipeline_sample(resArgs->pipeline, STAGE_NORMALIZE, RawQueue_count(queue));
+    normalize_request(resArgs, raw);
+  }
+
+  free(raw);
+  return 0;
+}
+
+// Definition of formatter thread.
+void* formatter(void* args)
+{
+  struct ResolverArgs* resArgs = (struct ResolverArgs *) args;
+  ResultQueue* queue = resArgs->pipeline->formatQueue;
+  Result* result = malloc(sizeof(Result));
+  trace_thread("formatter");
+
+  while(result != NULL && ResultQueue_get(queue, result) == 0){
+    pipeline_sample(resArgs->pipeline, STAGE_FORMAT, ResultQueue_count(queue));
+    format_result(resArgs, result);
+  }
+
+  free(result);
+  return 0;
+}
+
+// Definition of writer thread.
+void* writer(void* args)
+{
+  struct ResolverArgs* resArgs = (struct ResolverArgs *) args;
+  LineQueue* queue = resArgs->pipeline->writeQueue;
+  Line* line = malloc(sizeof(Line));
+  trace_thread("writer");
+
+  while(line != NULL && LineQueue_get(queue, line) == 0){
+    pipeline_sample(resArgs->pipeline, STAGE_WRITE, LineQueue_count(queue));
+    write_line(resArgs, line);
+  }
+
+  free(line);
+  return 0;
+}
+
+// Definition of resolve_window method of multi-lookup.
+int resolve_window(struct ResolverArgs* resArgs, DnsClient* client, int row)
+{
+  int numHostnames = 0;
+  int open = 1;
+  Result* results = malloc(DNS_WINDOW * sizeof(Result));
+  DnsQuery* queries = malloc(DNS_WINDOW * sizeof(DnsQuery));
+  DnsQuery* done[DNS_WINDOW];
+  long long started[DNS_WINDOW];
+  long epochs[DNS_WINDOW];
+  int freeSlots[DNS_WINDOW];
+  int numFree = DNS_WINDOW;
+  for(int i = 0; i < DNS_WINDOW; i++){
+    freeSlots[i] = i;
+  }
+
+  while(results != NULL && queries != NULL && (open || numFree < DNS_WINDOW))
+  {
+    // Top the window up with whatever is waiting in the shared array.  Only wait for a hostname when none are in flight.
+    while(open && numFree > 0){
+      int i = freeSlots[numFree - 1];
+      Request* request = &results[i].request;
+      if(take_request(request, numFree == DNS_WINDOW, row, i) != 0){
+	if(numFree == DNS_WINDOW){
+	  open = 0;
+	}
+	break;
+      }
+      numFree--;
+
+      pipeline_sample(resArgs->pipeline, STAGE_RESOLVE, get_num_elements());
+      started[i] = trace_now();
+      queries[i].hostname = intern_name(request->host);
+      queries[i].firstIPstr = results[i].ip;
+      queries[i].maxSize = INET6_ADDRSTRLEN;
+      if(request->traced){
+	trace_event(TRACE_DEQUEUE, request, queries[i].hostname, started[i]);
+      }
+
+      // Every query in the window still counts against the rate limit on its own.
+      if(resArgs->limiter != NULL){
+	epochs[i] = limiter_acquire(resArgs->limiter);
+      }
+      dnsclient_submit(client, &queries[i]);
+    }
+    if(numFree == DNS_WINDOW){
+      continue;
+    }
+
+    // Collect answers.  While there is room in the window, come back soon to fill it.
+    long long start = trace_now();
+    int count = dnsclient_poll(client, done, open && numFree > 0 ? DNS_REFILL_MS : DNS_TIMEOUT_MS);
+    for(int k = 0; k < count; k++){
+      int i = done[k] - queries;
+      results[i].err = queries[i].result;
+      if(resArgs->limiter != NULL){
+	limiter_report(resArgs->limiter, epochs[i], results[i].err);
+      }
+      if(results[i].request.traced){
+	trace_event(TRACE_LOOKUP, &results[i].request, queries[i].hostname, started[i]);
+      }
+      if(results[i].err == UTIL_SUCCESS){
+	numHostnames++;
+      }
+    }
+    pipeline_count(resArgs->pipeline, STAGE_RESOLVE, count, start);
+
+    for(int k = 0; k < count; k++){
+      int i = done[k] - queries;
+      pass_result(resArgs, &results[i]);
+      release_request(row, i);
+      freeSlots[numFree++] = i;
+    }
+  }
+
+  free(results);
+  free(queries);
+  return numHostnames;
+}
+
 // Definition of resolver thread.
 void* resolver(void* args)
 {
   int numHostnames = 0;
   struct ResolverArgs* resArgs = (struct ResolverArgs *) args;
-  char* hostname = malloc(sizeof(char) * MAX_NAME_LENGTH);
-  memset(hostname, '\0', MAX_NAME_LENGTH);
+  Result* result = malloc(sizeof(Result));
+  memset(result, '\0', sizeof(Result));
+  Request* request = &result->request;
+  int row = hold_row();
+  trace_thread("resolver");
 
-  while(1)
+  // The native client keeps a window of lookups in flight.  If its sockets can't be opened, fall back on getaddrinfo.
+  DnsClient client;
+  if(resArgs->dnsServer != NULL && dnsclient_init(&client, resArgs->dnsServer) == UTIL_SUCCESS){
+    numHostnames = resolve_window(resArgs, &client, row);
+    dnsclient_close(&client);
+  }
+
+  // Keep resolving until the shared array is closed and empty.
+  while(take_request(request, 1, row, 0) == 0)
   {
-    if(resArgs->data->processed == resArgs->data->total && get_num_elements() == 0){
-      break;
+    long long start = trace_now();
+    long long lookupStart = 0;
+    const char* hostname = intern_name(request->host);
+    pipeline_sample(resArgs->pipeline, STAGE_RESOLVE, get_num_elements());
+    if(request->traced){
+      trace_event(TRACE_DEQUEUE, request, hostname, start);
+      lookupStart = trace_now();
     }
-    int err;
-    
-    ts_read(hostname);
-
-    // Create string for the hostname, separator string, and ip address (or NOT_RESOLVED).
-    char temp[MAX_NAME_LENGTH+INET6_ADDRSTRLEN+2];
-    char seperator[3] = ", \0";
-    char ip[INET6_ADDRSTRLEN+1];
-    char endline[2] = "\n\0";
-    memset(ip, '\0', sizeof(INET6_ADDRSTRLEN));
-    memset(temp, '\0', sizeof(temp));
-
-    // Resolve hostname
-    err = dnslookup(hostname, ip, INET6_ADDRSTRLEN);
-
-    // Build resolution string
-    strcat(temp, hostname);
-    strcat(temp, seperator);
-
-    // If dnslookup succeeded, append returned ip to temp string.  Otherwise append NOT_RESOLVED.
-    if(err == UTIL_SUCCESS)
-    {
-      strcat(temp, ip);
-      strcat(temp, endline);
+
+    memset(result->ip, '\0', sizeof(result->ip));
+
+    // Resolve hostname, at whatever rate the upstream is currently putting up with.
+    long epoch = 0;
+    if(resArgs->limiter != NULL){
+      epoch = limiter_acquire(resArgs->limiter);
+    }
+    result->err = dnslookup(hostname, result->ip, INET6_ADDRSTRLEN);
+    if(resArgs->limiter != NULL){
+      limiter_report(resArgs->limiter, epoch, result->err);
+    }
+    if(request->traced){
+      trace_event(TRACE_LOOKUP, request, hostname, lookupStart);
+    }
+    if(result->err == UTIL_SUCCESS){
       numHostnames++;
-    }else
-    {
-      char errorStr[14] = "NOT_RESOLVED\n\0";
-      strcat(temp, errorStr);
     }
+    pipeline_count(resArgs->pipeline, STAGE_RESOLVE, 1, start);
 
-    // Print temp string to serviced file.
-    pthread_mutex_lock(&resArgs->serviced.lock);
-    fputs(temp, resArgs->serviced.fd);
-    pthread_mutex_unlock(&resArgs->serviced.lock);
-  
+    pass_result(resArgs, result);
+    release_request(row, 0);
   }
 
   printf("%s%lu%s%d%s\n", "Thread ", pthread_self(), " resolved ", numHostnames, " hostnames.");
-  free(hostname);
+  free(result);
   return 0;
 }
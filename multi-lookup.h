@@ -3,30 +3,93 @@
  *  Created by Jeff Colgan; March 26, 2021.
  */
 
+// Needed for the CPU affinity calls, and must come before any system header.
+#define _GNU_SOURCE
+
 #include <pthread.h>
 #include <semaphore.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <sys/time.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #include "util.h"
 #include "ts_buffer.h"
 #include "input_processor.h"
+#include "options.h"
+#include "affinity.h"
+#include "checkpoint.h"
+#include "rate_limiter.h"
+#include "trace.h"
+#include "reorder.h"
+#include "pipeline.h"
 
 #define MAX_INPUT_FILES 100
 #define MAX_REQUESTER_THREADS 10
 #define MAX_RESOLVER_THREADS 10
+
+// How often a resolver using the native client checks the shared array for more hostnames while its window has room.
+#define DNS_REFILL_MS 1
+#define MAX_WORKER_PROCESSES 16
+
+// How many worker processes may die resolving one hostname before it is given up on, rather than killing them all.
+#define MAX_REQUEUES 2
 #define MAX_NAME_LENGTH 255
 #define MAX_IP_LENGTH INET6_ADDRSTRLEN
+#define USAGE "Usage: ./multi-lookup [--requester-cpus=LIST] [--resolver-cpus=LIST] [--numa-auto] [--worker-processes=N] [--checkpoint=FILE [--checkpoint-interval=SECONDS] [--resume]] [--rate=QPS [--max-rate=QPS]] [--manifest=FILE] [--input-dir=DIR] [--max-open-files=N] [--read-ahead=N] [--trace=FILE [--trace-sample=N]] [--ordered[=WINDOW]] [--dns-server=IP[:PORT]] [--normalizers=N] [--formatters=N] [--writers=N] <# requesters> <# resolvers> <requester log> <resolver log> [<data file> ...]"
+
 
+// The most requests one worker process can be holding at once.
+#define MAX_HELD (MAX_RESOLVER_THREADS * DNS_WINDOW)
 
+// The most requests a dead worker process can leave its replacement.  A replacement fills its slots with fresh requests
+// while it works through what it was left, so if it dies too it can leave nearly MAX_HELD more than it was given.  Any
+// more than this are given up on.
+#define MAX_PENDING (2 * MAX_HELD)
+
+// What a slot of held requests has in it.  A suspect is a request some earlier worker died holding.
+#define HELD_NONE 0
+#define HELD_FRESH 1
+#define HELD_SUSPECT 2
+
+/*
+ *  The requests one worker process holds: those it has taken and not yet passed on to the format stage, and those a dead
+ *  worker left for it, which it hasn't taken yet (pending).  They are kept in shared memory, so that if the worker dies
+ *  the supervisor can hand them to its replacement.  Each resolver thread claims a row, with a slot for every lookup it
+ *  can have in flight.  Only one suspect is taken at a time, so a hostname that kills workers is soon the only suspect
+ *  held when one dies, and innocent ones aren't given up on along with it.
+ */
+typedef struct WorkerHeld{
+  int rows;
+  int suspects;
+  int numPending;
+  Request pending[MAX_PENDING];
+  int used[MAX_RESOLVER_THREADS][DNS_WINDOW];
+  Request requests[MAX_RESOLVER_THREADS][DNS_WINDOW];
+} WorkerHeld;
+
+struct WorkerArgs{
+  int numWorkers;
+  int numResolvers;
+  pid_t pids[MAX_WORKER_PROCESSES];
+  WorkerHeld* held;
+  Request* requeued;
+  int numRequeued;
+  struct ResolverArgs* resolverArgs;
+  cpu_set_t* cpus;
+  int crashed;
+  long totalRequeued;
+  long lost;
+};
 
 int main(int argc, char* argv[]);
 /*
  *  Method to generate the requester threads.
- *  Params: the specified number of requester threads
- *  Returns: number of threads generated.
+ *  Params: the specified number of requester threads, the CPUs to pin them to (NULL to let the scheduler place them).
+ *  Returns: number of threads generated, which is less than asked for if one could not be created.
  */
-int generate_requesters(int numRequesters, pthread_t* tids, struct RequesterArgs* args);
+int generate_requesters(int numRequesters, pthread_t* tids, struct RequesterArgs* args, cpu_set_t* cpus);
 
 /*
  *  Method to join a number of threads given an array of pointers to their tids.
@@ -35,10 +98,70 @@ int join_threads(int numThreads, pthread_t* tids);
 
 /*
  *  Method to generate the resolver threads.
- *  Params: the specified number of resolver threads.
- *  Returns: number of threads generated.
+ *  Params: the specified number of resolver threads, the CPUs to pin them to (NULL to let the scheduler place them).
+ *  Returns: number of threads generated, which is less than asked for if one could not be created.
+ */
+int generate_resolvers(int numResolvers, pthread_t* tids, struct ResolverArgs* args, cpu_set_t* cpus);
+
+/*
+ *  Method to work out which CPUs each class of thread should be pinned to, from the --requester-cpus, --resolver-cpus
+ *  and --numa-auto flags.  In NUMA auto mode, any class without an explicit list is kept on the NUMA node main is
+ *  currently running on, so both thread classes and the shared array end up on one node.
+ *  Params: the parsed options, the requester and resolver sets to fill in, and pointers which are set to those sets
+ *  (or NULL for a class that should not be pinned).
+ *  Returns: 0 on success, -1 if a CPU list could not be parsed.
+ */
+int build_cpu_sets(Options* opts, cpu_set_t* reqSet, cpu_set_t* resSet, cpu_set_t** reqCpus, cpu_set_t** resCpus);
+
+/*
+ *  Method to start one resolver worker process.  The child runs the given number of resolver threads against the
+ *  shared array, which must have been set up with init_shared, and exits once the array is closed and drained.  Its
+ *  threads also resolve the args' requeued requests, which a dead worker had been holding, ahead of the array.
+ *  Params: the worker args shared with the supervisor, and the worker's slot in them.
+ *  Returns: the pid of the new process in the parent, or -1 if it could not be forked.
+ */
+pid_t spawn_worker(struct WorkerArgs* args, int slot);
+
+/*
+ *  Method for the worker supervisor thread.  The supervisor waits on every worker process.  If a worker dies, the
+ *  requests it held are handed to a replacement, which is started as long as there is still anything for it to resolve;
+ *  the robust mutex in the shared array lets the survivors carry on even if the dead worker was holding it.  A request
+ *  that more than MAX_REQUEUES workers have died holding is given up on.  A worker that dies after passing a result on
+ *  but before releasing its request has that hostname resolved, and written, twice.  If no worker is left running, say
+ *  because a replacement could not be forked, nothing would ever read the shared array again, so the supervisor gives
+ *  up on everything still in it, until it is closed.  The thread returns once every worker has exited and the array is
+ *  drained.
+ */
+void* supervisor(void* args);
+
+/*
+ *  Method to give up on a request no worker process will resolve.  The hostname goes on to the format stage as not
+ *  resolved, so it is still written (and checkpointed, and released by the reorder buffer), and it is counted as lost.
+ *  Params: the worker args shared with the supervisor, the request.
+ */
+void give_up(struct WorkerArgs* workers, Request* request);
+
+/*
+ *  Method for resolver threads to take the next hostname to resolve: one handed over from a dead worker, if this process
+ *  is its replacement and holds no other suspect, otherwise whatever is in the shared array.  In a worker process, the
+ *  request is recorded in one of the slots of the thread's row of held requests.
+ *  Params: where to store the request, whether to wait while the array is empty (like ts_read) or not (like
+ *  ts_try_read), and the thread's row (see hold_row) and slot in it.
+ *  Returns: 0 on success, nonzero if there is nothing to take.
+ */
+int take_request(Request* request, int block, int row, int slot);
+
+/*
+ *  Method for a resolver thread to claim a row of its worker process's held requests.
+ *  Returns: the row, or -1 if the thread isn't running in a worker process.
+ */
+int hold_row();
+
+/*
+ *  Method to record that a resolver thread has passed on the result of the request in a slot of its row.  It does
+ *  nothing for a row of -1.
  */
-int generate_resolvers(int numResolvers, pthread_t* tids, struct ResolverArgs* args);
+void release_request(int row, int slot);
 
 /*
  *  Method for requester threads.  This method does the work of requester threads.
@@ -50,17 +173,72 @@ int generate_resolvers(int numResolvers, pthread_t* tids, struct ResolverArgs* a
 void* requester(void *args);
 
 /*
- *  Method for resolver threads.  This method does the work of resolver threads.  
- *  Each resolver thread will read a hostname from the shared array and attempt to resolve the
- *  hostname to an ip address, using the provided dnslookup method in util.c.  The thread will write
- *  the hostname and ip address (or the string NOT RESOLVED) to the serviced.txt file.  When the shared
- *  array is empty and all requester threads have terminated, the resolver threads will terminate.
+ *  Method to write one resolved line to the serviced file, and record that its hostname is done.  Writers call it
+ *  directly, or in ordered mode the reorder buffer calls it once the line's turn comes.
+ *  Params: the resolver args, the request the line belongs to (its hostname is found from its ID), the ip address or
+ *  NOT_RESOLVED, and whether it is being written in input order (lines which aren't are flagged OUT_OF_ORDER).
  */
-void* resolver(void *args);
+void write_serviced(void* args, Request* request, const char* ip, int ordered);
 
+/*
+ *  Methods to hand an item on to the next stage of the pipeline: into the stage's buffer if it has threads of its own,
+ *  or straight to the stage's work, run by the calling thread, if it has none.
+ */
+void pass_request(struct ResolverArgs* resArgs, RawRequest* raw);
+void pass_result(struct ResolverArgs* resArgs, Result* result);
+void pass_line(struct ResolverArgs* resArgs, Line* line);
 
+/*
+ *  Method doing the normalize stage's work on one hostname.  The hostname is normalized and interned, and its request
+ *  carries its ID from then on.  If the hostname isn't valid, or its result is already known, it goes straight on to the
+ *  format stage; otherwise it is placed in the shared array for the resolvers.
+ */
+void normalize_request(struct ResolverArgs* resArgs, RawRequest* raw);
 
+/*
+ *  Method doing the format stage's work on one result.  The result is stored in the intern table for the normalize stage,
+ *  and the normalized hostname and its ip address (or the string NOT_RESOLVED) are made into a serviced line.
+ */
+void format_result(struct ResolverArgs* resArgs, Result* result);
 
+/*
+ *  Method doing the write stage's work on one line: it is written to the serviced file, or in ordered mode handed to the
+ *  reorder buffer.
+ */
+void write_line(struct ResolverArgs* resArgs, Line* line);
 
+/*
+ *  Methods for normalizer, formatter and writer threads.  Each takes items from its stage's buffer and does the stage's
+ *  work on them, until the buffer is closed and empty.
+ */
+void* normalizer(void* args);
+void* formatter(void* args);
+void* writer(void* args);
 
+/*
+ *  Method to generate the threads of one stage of the pipeline, which generate_requesters and generate_resolvers do too.
+ *  Params: the number of threads, where to store their tids, the stage's thread method and its args, what to call the
+ *  threads in an error message, the CPUs to pin them to (NULL to let the scheduler place them).
+ *  Returns: number of threads generated, which is less than asked for if one could not be created.
+ */
+int generate_stage(int numThreads, pthread_t* tids, void* (*routine)(void *), void* args, const char* name, cpu_set_t* cpus);
+
+/*
+ *  Method for resolver threads using the native DNS client.  The thread keeps up to DNS_WINDOW lookups in flight,
+ *  topping the window up from the shared array as answers come back, so one lost reply only holds up its own hostname.
+ *  While the window has room, it checks the shared array again every DNS_REFILL_MS.  Returns once the shared array is
+ *  closed and empty and every lookup has finished.
+ *  Params: the resolver args, the thread's own client, already initialized, and its row of held requests (see hold_row).
+ *  Returns: the number of hostnames resolved.
+ */
+int resolve_window(struct ResolverArgs* resArgs, DnsClient* client, int row);
 
+/*
+ *  Method for resolver threads.  This method does the work of resolver threads.  
+ *  Each resolver thread will read a hostname from the shared array and attempt to resolve the
+ *  hostname to an ip address, using the provided dnslookup method in util.c (or, with --dns-server, the native client
+ *  in resolve_window).  The thread will pass
+ *  the result on to the format stage.  When the shared
+ *  array is empty and all requester threads have terminated, the resolver threads will terminate.
+ */
+void* resolver(void *args);
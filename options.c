@@ -0,0 +1,174 @@
+/*
+ *  CSCI-3753 Design and Analysis of Operating Systems PA3 Bounded Buffer problem - options definition.
+ */
+
+#include <getopt.h>
+#include "options.h"
+
+// Identifiers for flags which have no short form.
+enum{
+  OPT_REQUESTER_CPUS = 256,
+  OPT_RESOLVER_CPUS,
+  OPT_NUMA_AUTO,
+  OPT_WORKER_PROCESSES,
+  OPT_CHECKPOINT,
+  OPT_CHECKPOINT_INTERVAL,
+  OPT_RESUME,
+  OPT_RATE,
+  OPT_MAX_RATE,
+  OPT_MANIFEST,
+  OPT_INPUT_DIR,
+  OPT_MAX_OPEN_FILES,
+  OPT_READ_AHEAD,
+  OPT_TRACE,
+  OPT_TRACE_SAMPLE,
+  OPT_ORDERED,
+  OPT_DNS_SERVER,
+  OPT_NORMALIZERS,
+  OPT_FORMATTERS,
+  OPT_WRITERS
+};
+
+static struct option longOptions[] = {
+  {"requester-cpus", required_argument, NULL, OPT_REQUESTER_CPUS},
+  {"resolver-cpus", required_argument, NULL, OPT_RESOLVER_CPUS},
+  {"numa-auto", no_argument, NULL, OPT_NUMA_AUTO},
+  {"worker-processes", required_argument, NULL, OPT_WORKER_PROCESSES},
+  {"checkpoint", required_argument, NULL, OPT_CHECKPOINT},
+  {"checkpoint-interval", required_argument, NULL, OPT_CHECKPOINT_INTERVAL},
+  {"resume", no_argument, NULL, OPT_RESUME},
+  {"rate", required_argument, NULL, OPT_RATE},
+  {"max-rate", required_argument, NULL, OPT_MAX_RATE},
+  {"manifest", required_argument, NULL, OPT_MANIFEST},
+  {"input-dir", required_argument, NULL, OPT_INPUT_DIR},
+  {"max-open-files", required_argument, NULL, OPT_MAX_OPEN_FILES},
+  {"read-ahead", required_argument, NULL, OPT_READ_AHEAD},
+  {"trace", required_argument, NULL, OPT_TRACE},
+  {"trace-sample", required_argument, NULL, OPT_TRACE_SAMPLE},
+  {"ordered", optional_argument, NULL, OPT_ORDERED},
+  {"dns-server", required_argument, NULL, OPT_DNS_SERVER},
+  {"normalizers", required_argument, NULL, OPT_NORMALIZERS},
+  {"formatters", required_argument, NULL, OPT_FORMATTERS},
+  {"writers", required_argument, NULL, OPT_WRITERS},
+  {NULL, 0, NULL, 0}
+};
+
+// Definition of parse_options method.
+int parse_options(int argc, char* argv[], Options* opts){
+
+  // Default values, used for every flag the user leaves out.
+  opts->requesterCpus = NULL;
+  opts->resolverCpus = NULL;
+  opts->numaAuto = 0;
+  opts->workerProcesses = 0;
+  opts->checkpoint = NULL;
+  opts->checkpointInterval = DEFAULT_CHECKPOINT_INTERVAL;
+  opts->resume = 0;
+  opts->rate = 0;
+  opts->maxRate = 0;
+  opts->manifest = NULL;
+  opts->inputDir = NULL;
+  opts->maxOpenFiles = DEFAULT_MAX_OPEN_FILES;
+  opts->readAhead = DEFAULT_READ_AHEAD;
+  opts->trace = NULL;
+  opts->traceSample = DEFAULT_TRACE_SAMPLE;
+  opts->ordered = 0;
+  opts->dnsServer = NULL;
+  opts->normalizers = DEFAULT_STAGE_THREADS;
+  opts->formatters = DEFAULT_STAGE_THREADS;
+  opts->writers = DEFAULT_STAGE_THREADS;
+
+  int opt;
+  while((opt = getopt_long(argc, argv, "", longOptions, NULL)) != -1){
+    switch(opt){
+    case OPT_REQUESTER_CPUS:
+      opts->requesterCpus = optarg;
+      break;
+    case OPT_RESOLVER_CPUS:
+      opts->resolverCpus = optarg;
+      break;
+    case OPT_NUMA_AUTO:
+      opts->numaAuto = 1;
+      break;
+    case OPT_WORKER_PROCESSES:
+      if(sscanf(optarg, "%d", &opts->workerProcesses) != 1){
+	return -1;
+      }
+      break;
+    case OPT_CHECKPOINT:
+      opts->checkpoint = optarg;
+      break;
+    case OPT_CHECKPOINT_INTERVAL:
+      if(sscanf(optarg, "%d", &opts->checkpointInterval) != 1 || opts->checkpointInterval < 0){
+	return -1;
+      }
+      break;
+    case OPT_RESUME:
+      opts->resume = 1;
+      break;
+    case OPT_RATE:
+      if(sscanf(optarg, "%lf", &opts->rate) != 1 || opts->rate <= 0){
+	return -1;
+      }
+      break;
+    case OPT_MAX_RATE:
+      if(sscanf(optarg, "%lf", &opts->maxRate) != 1 || opts->maxRate <= 0){
+	return -1;
+      }
+      break;
+    case OPT_MANIFEST:
+      opts->manifest = optarg;
+      break;
+    case OPT_INPUT_DIR:
+      opts->inputDir = optarg;
+      break;
+    case OPT_MAX_OPEN_FILES:
+      if(sscanf(optarg, "%d", &opts->maxOpenFiles) != 1 || opts->maxOpenFiles < 1){
+	return -1;
+      }
+      break;
+    case OPT_READ_AHEAD:
+      if(sscanf(optarg, "%d", &opts->readAhead) != 1 || opts->readAhead < 0){
+	return -1;
+      }
+      break;
+    case OPT_TRACE:
+      opts->trace = optarg;
+      break;
+    case OPT_TRACE_SAMPLE:
+      if(sscanf(optarg, "%d", &opts->traceSample) != 1 || opts->traceSample < 1){
+	return -1;
+      }
+      break;
+    case OPT_ORDERED:
+      opts->ordered = DEFAULT_REORDER_WINDOW;
+      if(optarg != NULL && (sscanf(optarg, "%d", &opts->ordered) != 1 || opts->ordered < 1)){
+	return -1;
+      }
+      break;
+    case OPT_DNS_SERVER:
+      opts->dnsServer = optarg;
+      break;
+    case OPT_NORMALIZERS:
+      if(sscanf(optarg, "%d", &opts->normalizers) != 1 || opts->normalizers < 0 || opts->normalizers > MAX_STAGE_THREADS){
+	return -1;
+      }
+      break;
+    case OPT_FORMATTERS:
+      if(sscanf(optarg, "%d", &opts->formatters) != 1 || opts->formatters < 0 || opts->formatters > MAX_STAGE_THREADS){
+	return -1;
+      }
+      break;
+    case OPT_WRITERS:
+      if(sscanf(optarg, "%d", &opts->writers) != 1 || opts->writers < 0 || opts->writers > MAX_STAGE_THREADS){
+	return -1;
+      }
+      break;
+    default:
+      // getopt_long has already printed a description of the bad flag.
+      return -1;
+    }
+  }
+
+  return optind;
+}
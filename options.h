@@ -0,0 +1,55 @@
+/*
+ *  CSCI-3753 Design and Analysis of Operating Systems, PA3 Bounded Buffer Problem - options header file.
+ *
+ *  multi-lookup still takes its original positional arguments, but a number of optional tuning flags can now
+ *  be given in front of (or mixed in with) them.  This header defines the struct that holds the parsed flags
+ *  and the method used to parse them out of argv.
+ */
+
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "trace.h"
+#include "reorder.h"
+#include "pipeline.h"
+
+#define DEFAULT_CHECKPOINT_INTERVAL 30
+#define DEFAULT_MAX_OPEN_FILES 64
+#define DEFAULT_READ_AHEAD 2
+
+typedef struct Options{
+  char* requesterCpus;
+  char* resolverCpus;
+  int numaAuto;
+  int workerProcesses;
+  char* checkpoint;
+  int checkpointInterval;
+  int resume;
+  double rate;
+  double maxRate;
+  char* manifest;
+  char* inputDir;
+  int maxOpenFiles;
+  int readAhead;
+  char* trace;
+  int traceSample;
+  int ordered;
+  char* dnsServer;
+  int normalizers;
+  int formatters;
+  int writers;
+} Options;
+
+/*
+ *  Prototype of parse_options method.
+ *  This method parses every optional "--flag" argument out of argv using getopt_long and stores the results in the
+ *  given Options struct.  Flags which are not given keep their default values.  Because GNU getopt permutes argv,
+ *  the positional arguments are left at the end of argv, starting at the returned index.
+ *  Params:  argc and argv from main, the struct to be populated.
+ *  Returns the index of the first positional argument on success, -1 if an unknown or malformed flag was given.
+ */
+int parse_options(int argc, char* argv[], Options* opts);
+
+#endif
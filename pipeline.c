@@ -0,0 +1,150 @@
+/*
+ *  CSCI-3753 Design and Analysis of Operating Systems PA3 Bounded Buffer problem - pipeline definition.
+ */
+
+#include <sys/mman.h>
+#include <string.h>
+#include <stdlib.h>
+#include "pipeline.h"
+#include "util.h"
+#include "trace.h"
+
+static const char* stageNames[NUM_STAGES] = {"read", "normalize", "resolve", "format", "write"};
+
+// Map fresh zeroed memory, shared with forked children if asked.
+static void* map_zeroed(size_t size, int shared)
+{
+  void* memory = mmap(NULL, size, PROT_READ | PROT_WRITE, (shared ? MAP_SHARED : MAP_PRIVATE) | MAP_ANONYMOUS, -1, 0);
+  if(memory == MAP_FAILED){
+    return NULL;
+  }
+  memset(memory, 0, size);
+  return memory;
+}
+
+// Definition of pipeline_create method.
+Pipeline* pipeline_create(int threads[NUM_STAGES], int shared, unsigned long inputBytes)
+{
+  Pipeline* pipeline = calloc(1, sizeof(Pipeline));
+  if(pipeline == NULL){
+    return NULL;
+  }
+  memcpy(pipeline->threads, threads, sizeof(pipeline->threads));
+  pipeline->shared = shared;
+
+  // Anything worker processes touch has to be shared with them; the normalize buffer never leaves this process.
+  pipeline->stats = map_zeroed(NUM_STAGES * sizeof(StageStats), shared);
+  pipeline->normalizeQueue = map_zeroed(sizeof(RawQueue), 0);
+  pipeline->formatQueue = map_zeroed(sizeof(ResultQueue), shared);
+  pipeline->writeQueue = map_zeroed(sizeof(LineQueue), shared);
+  if(pipeline->stats == NULL || pipeline->normalizeQueue == NULL || pipeline->formatQueue == NULL || pipeline->writeQueue == NULL
+     || RawQueue_init(pipeline->normalizeQueue, 0) != 0 || ResultQueue_init(pipeline->formatQueue, shared) != 0
+     || LineQueue_init(pipeline->writeQueue, shared) != 0){
+    printf("%s\n", "ERROR: Failed to initialize the pipeline's buffers!");
+    pipeline_destroy(pipeline);
+    return NULL;
+  }
+
+  // The intern table is always shared memory, since it has to be in place before the worker processes are forked.
+  if(intern_init(inputBytes, shared) != 0){
+    printf("%s\n", "ERROR: Failed to map the intern table!");
+    pipeline_destroy(pipeline);
+    return NULL;
+  }
+
+  for(int i = 0; i < NUM_STAGES; i++){
+    pipeline->stats[i].threads = threads[i];
+  }
+  pipeline->stats[STAGE_NORMALIZE].capacity = STAGE_QUEUE_SIZE;
+  pipeline->stats[STAGE_RESOLVE].capacity = MAX_ARRAY_SIZE;
+  pipeline->stats[STAGE_FORMAT].capacity = STAGE_QUEUE_SIZE;
+  pipeline->stats[STAGE_WRITE].capacity = STAGE_QUEUE_SIZE;
+
+  return pipeline;
+}
+
+// Definition of pipeline_count method.
+void pipeline_count(Pipeline* pipeline, int stage, long items, long long start)
+{
+  StageStats* stats = &pipeline->stats[stage];
+  __atomic_fetch_add(&stats->items, items, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&stats->busy, trace_now() - start, __ATOMIC_RELAXED);
+}
+
+// Definition of pipeline_sample method.
+void pipeline_sample(Pipeline* pipeline, int stage, int occupied)
+{
+  StageStats* stats = &pipeline->stats[stage];
+  __atomic_fetch_add(&stats->samples, 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&stats->occupied, occupied, __ATOMIC_RELAXED);
+}
+
+// Definition of cache_lookup method.
+int cache_lookup(Pipeline* pipeline, uint32_t host, int* err, char* ip)
+{
+  if(!intern_result(host, err, ip)){
+    return 0;
+  }
+  __atomic_fetch_add(&pipeline->hits, 1, __ATOMIC_RELAXED);
+  return 1;
+}
+
+// Definition of cache_store method.
+void cache_store(Result* result)
+{
+  if(result->err != UTIL_TRYAGAIN){
+    intern_store(result->request.host, result->err, result->ip);
+  }
+}
+
+// Definition of pipeline_report method.
+void pipeline_report(Pipeline* pipeline, FILE* out, double seconds)
+{
+  fprintf(out, "%s\n", "Pipeline stages:");
+  for(int i = 0; i < NUM_STAGES; i++){
+    StageStats* stats = &pipeline->stats[i];
+    double rate = seconds > 0 ? stats->items / seconds : 0;
+
+    // A stage without threads of its own is run by the one before it, so it has no buffer and no threads to be busy.
+    if(stats->threads == 0){
+      fprintf(out, "  %-9s  inline    %9ld items  %10.1f items/s  (run by the %s stage)\n", stageNames[i], stats->items, rate, stageNames[i - 1]);
+      continue;
+    }
+
+    double busy = seconds > 0 ? 100.0 * stats->busy / 1e9 / (seconds * stats->threads) : 0;
+    fprintf(out, "  %-9s  %2d threads %9ld items  %10.1f items/s  %5.1f%% busy", stageNames[i], stats->threads, stats->items, rate, busy);
+    if(stats->capacity > 0 && stats->samples > 0){
+      fprintf(out, "  buffer %5.1f%% full\n", 100.0 * stats->occupied / stats->samples / stats->capacity);
+    }else{
+      fprintf(out, "\n");
+    }
+  }
+  fprintf(out, "%s%ld%s\n", "  ", pipeline->hits, " hostnames were already known and skipped the resolve stage.");
+
+  unsigned long bytes;
+  long distinct = intern_count(&bytes);
+  fprintf(out, "%s%ld%s%lu%s\n", "  ", distinct, " distinct hostnames were interned, in ", bytes, " bytes.");
+}
+
+// Definition of pipeline_destroy method.
+void pipeline_destroy(Pipeline* pipeline)
+{
+  if(pipeline->normalizeQueue != NULL){
+    RawQueue_destroy(pipeline->normalizeQueue);
+    munmap(pipeline->normalizeQueue, sizeof(RawQueue));
+  }
+  if(pipeline->formatQueue != NULL){
+    ResultQueue_destroy(pipeline->formatQueue);
+    munmap(pipeline->formatQueue, sizeof(ResultQueue));
+  }
+  if(pipeline->writeQueue != NULL){
+    LineQueue_destroy(pipeline->writeQueue);
+    munmap(pipeline->writeQueue, sizeof(LineQueue));
+  }
+  if(pipeline->stats != NULL){
+    munmap(pipeline->stats, NUM_STAGES * sizeof(StageStats));
+  }
+
+  intern_destroy();
+  free(pipeline);
+}
@@ -0,0 +1,144 @@
+/*
+ *  CSCI-3753 Design and Analysis of Operating Systems, PA3 Bounded Buffer Problem - pipeline header file.
+ *
+ *  multi-lookup runs as a pipeline of five stages, each with its own threads and a bounded buffer in front of it:
+ *
+ *    read       requesters read hostnames from the input files and log them to the results log
+ *    normalize  hostnames are normalized and interned, and any hostname whose result is already known skips the resolve stage
+ *    resolve    resolvers look hostnames up; the shared array from ts_buffer is this stage's buffer
+ *    format     results are turned into serviced lines, and remembered for the normalize stage
+ *    write      lines are written to the serviced log, or handed to the reorder buffer
+ *
+ *  A stage given 0 threads is run inline by the threads of the stage before it, with no buffer in between, so cheap
+ *  stages can be folded into their neighbours.  Every stage counts the items it handles, the time its threads spend
+ *  busy with them, and how full its buffer is each time an item is taken out, so the report at the end of a run shows
+ *  which stage is the bottleneck.
+ *
+ *  After the normalize stage a hostname is only referred to by its ID in the intern table, which also holds the known
+ *  results.  When the resolvers run in worker processes, the format and write buffers and the statistics are placed in
+ *  shared memory, so the workers can hand their results back to the format and write threads in the main process.
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <pthread.h>
+#include <stdio.h>
+#include <netinet/in.h>
+#include "ts_buffer.h"
+#include "bounded_buffer.h"
+#include "intern.h"
+
+#define STAGE_READ 0
+#define STAGE_NORMALIZE 1
+#define STAGE_RESOLVE 2
+#define STAGE_FORMAT 3
+#define STAGE_WRITE 4
+#define NUM_STAGES 5
+
+// Capacity of the buffers between stages, other than the shared array.  A power of two, so slots are found by masking.
+#define STAGE_QUEUE_SIZE 64
+#define MAX_STAGE_THREADS 10
+#define DEFAULT_STAGE_THREADS 1
+
+// A line as it was read, on its way from the read stage to the normalize stage, which interns its hostname.  This is
+// the only place a hostname's text travels between threads.
+typedef struct RawRequest{
+  Request request;
+  char hostname[MAX_NAME_LENGTH];
+} RawRequest;
+
+// A hostname's lookup result, on its way from the resolve stage to the format stage.
+typedef struct Result{
+  Request request;
+  int err;
+  char ip[INET6_ADDRSTRLEN];
+} Result;
+
+// A serviced line, on its way from the format stage to the write stage.  The line is "<hostname>, <ip>", but only the ip
+// address (or NOT_RESOLVED) is carried: the hostname is looked up by its ID when the line is written.
+typedef struct Line{
+  Request request;
+  char ip[INET6_ADDRSTRLEN];
+} Line;
+
+DEFINE_BOUNDED_BUFFER(RawQueue, RawRequest, STAGE_QUEUE_SIZE)
+DEFINE_BOUNDED_BUFFER(ResultQueue, Result, STAGE_QUEUE_SIZE)
+DEFINE_BOUNDED_BUFFER(LineQueue, Line, STAGE_QUEUE_SIZE)
+
+// One stage's counters.  They are only ever added to, atomically, so threads in any process can update them.
+typedef struct StageStats{
+  int threads;
+  int capacity;
+  long items;
+  long long busy;
+  long samples;
+  long occupied;
+} StageStats;
+
+typedef struct Pipeline{
+  int threads[NUM_STAGES];
+  StageStats* stats;
+  RawQueue* normalizeQueue;
+  ResultQueue* formatQueue;
+  LineQueue* writeQueue;
+  int shared;
+  long hits;
+} Pipeline;
+
+/*
+ *  Prototype of pipeline_create method.
+ *  This method allocates a pipeline, the buffers in front of its normalize, format and write stages, and the intern table.
+ *  It must be called before any worker process is forked.
+ *  Params:  the number of threads of each stage (the resolve stage counting every resolver in every worker process),
+ *  whether the resolvers run in worker processes, and the most bytes of input the run can read, to size the intern table.
+ *  Returns the pipeline, or NULL on failure.
+ */
+Pipeline* pipeline_create(int threads[NUM_STAGES], int shared, unsigned long inputBytes);
+
+/*
+ *  Prototype of pipeline_count method.
+ *  This method records that a stage has finished with some items.
+ *  Params:  the pipeline, the stage, the number of items (more than one when they were handled as a batch), and the time
+ *  (from trace_now) it started on them.
+ */
+void pipeline_count(Pipeline* pipeline, int stage, long items, long long start);
+
+/*
+ *  Prototype of pipeline_sample method.
+ *  This method records how many items were left in a stage's buffer just after one was taken out.
+ *  Params:  the pipeline, the stage, the number of items in its buffer.
+ */
+void pipeline_sample(Pipeline* pipeline, int stage, int occupied);
+
+/*
+ *  Prototype of cache_lookup method.
+ *  This method looks up the result stored in the intern table for a hostname.
+ *  Params:  the pipeline, the hostname's ID, and where to store its lookup result and ip address on a hit.
+ *  Returns 1 on a hit, 0 otherwise.
+ */
+int cache_lookup(Pipeline* pipeline, uint32_t host, int* err, char* ip);
+
+/*
+ *  Prototype of cache_store method.
+ *  This method stores a hostname's result in the intern table, unless the lookup only failed temporarily and is worth
+ *  trying again.  It may be called from a worker process.
+ *  Params:  the result.
+ */
+void cache_store(Result* result);
+
+/*
+ *  Prototype of pipeline_report method.
+ *  This method prints each stage's thread count, items handled, throughput, how busy its threads were, and how full its
+ *  buffer was on average, followed by how many distinct hostnames were interned.
+ *  Params:  the pipeline, where to print the report, the length of the run in seconds.
+ */
+void pipeline_report(Pipeline* pipeline, FILE* out, double seconds);
+
+/*
+ *  Prototype of pipeline_destroy method.
+ *  This method frees the pipeline, its buffers and the intern table.
+ */
+void pipeline_destroy(Pipeline* pipeline);
+
+#endif
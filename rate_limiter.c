@@ -0,0 +1,160 @@
+/*
+ *  CSCI-3753 Design and Analysis of Operating Systems PA3 Bounded Buffer problem - rate_limiter definition.
+ */
+
+#include <sys/mman.h>
+#include <errno.h>
+#include <string.h>
+#include "rate_limiter.h"
+#include "util.h"
+
+// Lock the limiter, recovering the mutex if a worker process died while holding it.
+static void lock_limiter(RateLimiter* limiter)
+{
+  if(pthread_mutex_lock(&limiter->lock) == EOWNERDEAD){
+    pthread_mutex_consistent(&limiter->lock);
+  }
+}
+
+// Seconds elapsed between two timestamps.
+static double elapsed(struct timespec* from, struct timespec* to)
+{
+  return (double)(to->tv_sec - from->tv_sec) + (double)(to->tv_nsec - from->tv_nsec) / 1000000000;
+}
+
+// The most tokens the bucket may hold: a tenth of a second's worth, so idle time can't be saved up into a burst.
+static double burst(RateLimiter* limiter)
+{
+  return 1.0 + limiter->rate / 10;
+}
+
+// Definition of limiter_create method.
+RateLimiter* limiter_create(double rate, double maxRate, int shared)
+{
+  RateLimiter* limiter = mmap(NULL, sizeof(*limiter), PROT_READ | PROT_WRITE, (shared ? MAP_SHARED : MAP_PRIVATE) | MAP_ANONYMOUS, -1, 0);
+  if(limiter == MAP_FAILED){
+    return NULL;
+  }
+  memset(limiter, 0, sizeof(*limiter));
+
+  pthread_mutexattr_t attr;
+  pthread_mutexattr_init(&attr);
+  if(shared){
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+  }
+  int err = pthread_mutex_init(&limiter->lock, &attr);
+  pthread_mutexattr_destroy(&attr);
+  if(err != 0){
+    munmap(limiter, sizeof(*limiter));
+    return NULL;
+  }
+
+  // The starting rate is held to the highest rate allowed, just like every increase after it.
+  if(maxRate > 0 && rate > maxRate){
+    rate = maxRate;
+  }
+  limiter->rate = rate;
+  limiter->maxRate = maxRate;
+  limiter->peakRate = rate;
+  limiter->tokens = 1.0;
+  clock_gettime(CLOCK_MONOTONIC, &limiter->last);
+  return limiter;
+}
+
+// Definition of limiter_acquire method.
+long limiter_acquire(RateLimiter* limiter)
+{
+  while(1){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    // Refill the bucket for the time since the last refill, and take a token if there is one.
+    lock_limiter(limiter);
+    limiter->tokens += elapsed(&limiter->last, &now) * limiter->rate;
+    if(limiter->tokens > burst(limiter)){
+      limiter->tokens = burst(limiter);
+    }
+    limiter->last = now;
+
+    if(limiter->tokens >= 1.0){
+      limiter->tokens -= 1.0;
+      long epoch = limiter->epoch;
+      pthread_mutex_unlock(&limiter->lock);
+      return epoch;
+    }
+
+    // Otherwise sleep until a whole token should have dripped in, then try again.
+    double wait = (1.0 - limiter->tokens) / limiter->rate;
+    pthread_mutex_unlock(&limiter->lock);
+
+    struct timespec nap;
+    nap.tv_sec = (time_t) wait;
+    nap.tv_nsec = (long)((wait - nap.tv_sec) * 1000000000);
+    nanosleep(&nap, NULL);
+  }
+}
+
+// Definition of limiter_report method.
+void limiter_report(RateLimiter* limiter, long epoch, int result)
+{
+  lock_limiter(limiter);
+  limiter->lookups++;
+  if(result == UTIL_TRYAGAIN){
+    limiter->drops++;
+  }
+
+  // A lookup sent before the last cut went out at the old rate, so it says nothing about the current one.
+  if(epoch != limiter->epoch){
+    pthread_mutex_unlock(&limiter->lock);
+    return;
+  }
+  limiter->windowResults++;
+
+  // Only temporary failures mean the upstream is struggling; a name that doesn't exist is still a good answer.
+  if(result == UTIL_TRYAGAIN){
+    limiter->windowFailures++;
+  }else{
+    // Additive increase: at full rate, the rate rises by AIMD_INCREASE every second.
+    limiter->rate += AIMD_INCREASE / limiter->rate;
+    if(limiter->maxRate > 0 && limiter->rate > limiter->maxRate){
+      limiter->rate = limiter->maxRate;
+    }
+    if(limiter->rate > limiter->peakRate){
+      limiter->peakRate = limiter->rate;
+    }
+  }
+
+  // Multiplicative decrease, at most once per window, if enough of the window failed.  The cut starts a new epoch.
+  if(limiter->windowFailures >= AIMD_WINDOW * AIMD_THRESHOLD){
+    limiter->rate *= AIMD_DECREASE;
+    if(limiter->rate < AIMD_MIN_RATE){
+      limiter->rate = AIMD_MIN_RATE;
+    }
+    limiter->decreases++;
+    limiter->epoch++;
+    limiter->windowResults = 0;
+    limiter->windowFailures = 0;
+  }else if(limiter->windowResults >= AIMD_WINDOW){
+    limiter->windowResults = 0;
+    limiter->windowFailures = 0;
+  }
+
+  pthread_mutex_unlock(&limiter->lock);
+}
+
+// Definition of limiter_summary method.
+void limiter_summary(RateLimiter* limiter, FILE* out)
+{
+  lock_limiter(limiter);
+  fprintf(out, "Rate limiter: %.1f lookups/s now, %.1f lookups/s peak; %ld of %ld lookups dropped or throttled upstream; rate cut %ld times.\n",
+	  limiter->rate, limiter->peakRate, limiter->drops, limiter->lookups, limiter->decreases);
+  pthread_mutex_unlock(&limiter->lock);
+}
+
+// Definition of limiter_destroy method.
+void limiter_destroy(RateLimiter* limiter)
+{
+  pthread_mutex_destroy(&limiter->lock);
+  munmap(limiter, sizeof(*limiter));
+}
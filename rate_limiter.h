@@ -0,0 +1,85 @@
+/*
+ *  CSCI-3753 Design and Analysis of Operating Systems, PA3 Bounded Buffer Problem - rate_limiter header file.
+ *
+ *  A token bucket shared by every resolver, which decides how many lookups per second are sent upstream.  The
+ *  rate adapts the same way TCP's congestion window does (additive increase, multiplicative decrease): every
+ *  successful lookup nudges the rate up a little, and whenever the share of lookups failing with a temporary error
+ *  (a timeout or SERVFAIL, which is how an overloaded upstream pushes back) crosses a threshold, the rate is cut in
+ *  half.  The result is that the resolvers settle just under whatever the upstream can actually take.
+ *
+ *  Every cut starts a new epoch, and each token is tagged with the epoch it was issued in.  Lookups that were already
+ *  in flight at the old rate when the rate was cut say nothing about the new rate, so their results are left out of
+ *  the windows after the cut; otherwise their failures would cut the rate again and again.
+ */
+
+#ifndef RATE_LIMITER_H
+#define RATE_LIMITER_H
+
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+
+// Lookups per second the rate rises by, per second spent at full rate without a failure spike.
+#define AIMD_INCREASE 10.0
+// What the rate is multiplied by on a failure spike.
+#define AIMD_DECREASE 0.5
+// Lookup results per measurement window, and the share of them that must fail for the window to count as a spike.
+#define AIMD_WINDOW 20
+#define AIMD_THRESHOLD 0.25
+// The rate is never cut below this many lookups per second, so the limiter can always find its way back up.
+#define AIMD_MIN_RATE 1.0
+
+typedef struct RateLimiter{
+  pthread_mutex_t lock;
+  double rate;
+  double maxRate;
+  double tokens;
+  struct timespec last;
+  long epoch;
+  int windowResults;
+  int windowFailures;
+  long lookups;
+  long drops;
+  long decreases;
+  double peakRate;
+} RateLimiter;
+
+/*
+ *  Prototype of limiter_create method.
+ *  This method maps and initializes a rate limiter.  If the resolvers are going to run in worker processes the
+ *  limiter is placed in shared memory with a process-shared, robust mutex, so that every worker draws from the one
+ *  bucket; it must then be created before the workers are forked.
+ *  Params:  the starting rate in lookups per second, the highest rate allowed (0 for no limit), which the starting rate
+ *  is capped to, whether it must be shared between processes.
+ *  Returns the limiter, or NULL on failure.
+ */
+RateLimiter* limiter_create(double rate, double maxRate, int shared);
+
+/*
+ *  Prototype of limiter_acquire method.
+ *  This method blocks the calling resolver until the bucket holds a token for it to spend on one lookup.
+ *  Returns the epoch the token was issued in, to be passed back with the lookup's result.
+ */
+long limiter_acquire(RateLimiter* limiter);
+
+/*
+ *  Prototype of limiter_report method.
+ *  This method feeds the result of one lookup back to the limiter, which adjusts the rate.  Results of lookups started
+ *  before the last cut are only counted in the summary.
+ *  Params:  the limiter, the epoch limiter_acquire returned for the lookup, the value dnslookup returned.
+ */
+void limiter_report(RateLimiter* limiter, long epoch, int result);
+
+/*
+ *  Prototype of limiter_summary method.
+ *  This method prints the limiter's current and peak rate and how often the upstream pushed back.
+ */
+void limiter_summary(RateLimiter* limiter, FILE* out);
+
+/*
+ *  Prototype of limiter_destroy method.
+ *  This method destroys the limiter's mutex and unmaps it.
+ */
+void limiter_destroy(RateLimiter* limiter);
+
+#endif
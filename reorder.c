@@ -0,0 +1,259 @@
+/*
+ *  CSCI-3753 Design and Analysis of Operating Systems PA3 Bounded Buffer problem - reorder definition.
+ *
+ *  Held lines are kept in a binary min-heap keyed by (file, line), so the earliest held line is always at the top.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include "reorder.h"
+
+// Whether line a comes before line b in input order.
+static int before(int fileA, long seqA, int fileB, long seqB)
+{
+  return fileA < fileB || (fileA == fileB && seqA < seqB);
+}
+
+// Whether held entry i comes before held entry j.
+static int entry_before(Reorder* reorder, int i, int j)
+{
+  Request* a = &reorder->heap[i].request;
+  Request* b = &reorder->heap[j].request;
+  return before(a->file, a->seq, b->file, b->seq);
+}
+
+static void swap_entries(Reorder* reorder, int i, int j)
+{
+  ReorderEntry temp = reorder->heap[i];
+  reorder->heap[i] = reorder->heap[j];
+  reorder->heap[j] = temp;
+}
+
+// Add an entry to the heap.
+static void push(Reorder* reorder, ReorderEntry* entry)
+{
+  int i = reorder->held++;
+  reorder->heap[i] = *entry;
+  while(i > 0 && entry_before(reorder, i, (i - 1) / 2)){
+    swap_entries(reorder, i, (i - 1) / 2);
+    i = (i - 1) / 2;
+  }
+}
+
+// Remove the earliest entry from the heap.
+static ReorderEntry pop(Reorder* reorder)
+{
+  ReorderEntry top = reorder->heap[0];
+  reorder->heap[0] = reorder->heap[--reorder->held];
+
+  int i = 0;
+  while(1){
+    int smallest = i;
+    int left = 2 * i + 1;
+    int right = 2 * i + 2;
+    if(left < reorder->held && entry_before(reorder, left, smallest)){
+      smallest = left;
+    }
+    if(right < reorder->held && entry_before(reorder, right, smallest)){
+      smallest = right;
+    }
+    if(smallest == i){
+      break;
+    }
+    swap_entries(reorder, i, smallest);
+    i = smallest;
+  }
+  return top;
+}
+
+// Write an entry, making room in the window for requesters waiting to be admitted.
+static void emit(Reorder* reorder, ReorderEntry* entry, int ordered)
+{
+  const char* ip = entry->ip[0] != '\0' ? entry->ip : NULL;
+  if(!ordered && ip != NULL){
+    reorder->unordered++;
+  }
+  reorder->emit(reorder->ctx, &entry->request, ip, ordered);
+  reorder->pending--;
+  pthread_cond_broadcast(&reorder->moved);
+}
+
+// Move the expected line on past every file whose lines have all been written.
+static void skip_finished_files(Reorder* reorder)
+{
+  while(reorder->expectedFile < reorder->total && reorder->lines[reorder->expectedFile] >= 0
+	&& reorder->expectedSeq >= reorder->lines[reorder->expectedFile]){
+    reorder->expectedFile++;
+    reorder->expectedSeq = 0;
+  }
+}
+
+// Write every held line that is next in order.  The caller must hold the lock.
+static void drain(Reorder* reorder)
+{
+  skip_finished_files(reorder);
+  while(reorder->held > 0 && reorder->heap[0].request.file == reorder->expectedFile
+	&& reorder->heap[0].request.seq == reorder->expectedSeq){
+    ReorderEntry entry = pop(reorder);
+    emit(reorder, &entry, 1);
+    reorder->expectedSeq++;
+    skip_finished_files(reorder);
+  }
+}
+
+// Definition of reorder_init method.
+int reorder_init(Reorder* reorder, int total, int window, ReorderEmit emitLine, void* ctx)
+{
+  reorder->emit = emitLine;
+  reorder->ctx = ctx;
+  reorder->total = total;
+  reorder->expectedFile = 0;
+  reorder->expectedSeq = 0;
+  reorder->window = window;
+  reorder->pending = 0;
+  reorder->stalledFile = -1;
+  reorder->stalledSeq = -1;
+  reorder->held = 0;
+  reorder->unordered = 0;
+
+  // Line counts are unknown (-1) until each file's requester reaches its end.
+  reorder->lines = malloc((total + 1) * sizeof(long));
+  reorder->heap = malloc((window + 1) * sizeof(ReorderEntry));
+  if(reorder->lines == NULL || reorder->heap == NULL || pthread_mutex_init(&reorder->lock, NULL) != 0){
+    printf("%s\n", "ERROR: Failed to initialize the reorder buffer!");
+    free(reorder->lines);
+    free(reorder->heap);
+    return -1;
+  }
+  if(pthread_cond_init(&reorder->moved, NULL) != 0){
+    printf("%s\n", "ERROR: Failed to initialize the reorder buffer!");
+    pthread_mutex_destroy(&reorder->lock);
+    free(reorder->lines);
+    free(reorder->heap);
+    return -1;
+  }
+  for(int i = 0; i < total; i++){
+    reorder->lines[i] = -1;
+  }
+
+  return 0;
+}
+
+// Whether a line can be admitted to the window now.  The caller must hold the lock.
+static int admissible(Reorder* reorder, int file, long seq)
+{
+  // The line due next, or one the stream already gave up on, is always admitted, so the stream can always move on.
+  if(!before(reorder->expectedFile, reorder->expectedSeq, file, seq)){
+    return 1;
+  }
+  if(reorder->expectedFile == reorder->stalledFile && reorder->expectedSeq == reorder->stalledSeq){
+    return 1;
+  }
+
+  // Half the window is for the lines of the file being written, and half for lines read ahead from later files, so the
+  // window can never overflow while the stream is moving.
+  int half = (reorder->window + 1) / 2;
+  if(file == reorder->expectedFile){
+    return seq - reorder->expectedSeq < half;
+  }
+  return reorder->pending < half;
+}
+
+// Definition of reorder_admit method.
+void reorder_admit(Reorder* reorder, int file, long seq)
+{
+  int waitFile = -1;
+  long waitSeq = -1;
+  struct timespec deadline;
+
+  pthread_mutex_lock(&reorder->lock);
+  while(!admissible(reorder, file, seq)){
+    // The clock only restarts when the stream moves, not when room is freed by lines going out late.
+    if(reorder->expectedFile != waitFile || reorder->expectedSeq != waitSeq){
+      waitFile = reorder->expectedFile;
+      waitSeq = reorder->expectedSeq;
+      clock_gettime(CLOCK_REALTIME, &deadline);
+      deadline.tv_sec += REORDER_STALL_MS / 1000;
+      deadline.tv_nsec += (REORDER_STALL_MS % 1000) * 1000000L;
+      if(deadline.tv_nsec >= 1000000000L){
+	deadline.tv_sec++;
+	deadline.tv_nsec -= 1000000000L;
+      }
+    }
+
+    // If the stream still hasn't moved, the line due next is stuck in a lookup.  Stop holding requesters back until it
+    // moves again, and let the window overflow past it.
+    if(pthread_cond_timedwait(&reorder->moved, &reorder->lock, &deadline) == ETIMEDOUT
+       && reorder->expectedFile == waitFile && reorder->expectedSeq == waitSeq){
+      reorder->stalledFile = waitFile;
+      reorder->stalledSeq = waitSeq;
+      pthread_cond_broadcast(&reorder->moved);
+    }
+  }
+
+  reorder->pending++;
+  pthread_mutex_unlock(&reorder->lock);
+}
+
+// Definition of reorder_submit method.
+void reorder_submit(Reorder* reorder, Request* request, const char* ip)
+{
+  ReorderEntry entry;
+  entry.request = *request;
+  entry.ip[0] = '\0';
+  if(ip != NULL){
+    strncpy(entry.ip, ip, INET6_ADDRSTRLEN - 1);
+    entry.ip[INET6_ADDRSTRLEN - 1] = '\0';
+  }
+
+  pthread_mutex_lock(&reorder->lock);
+
+  if(before(request->file, request->seq, reorder->expectedFile, reorder->expectedSeq)){
+    // The stream already moved past this line when the window overflowed, so it can only go out late.
+    emit(reorder, &entry, 0);
+  }else{
+    push(reorder, &entry);
+    drain(reorder);
+
+    // If the window is full, give up waiting for whatever is missing: write the earliest held line and carry on after it.
+    while(reorder->held > reorder->window){
+      entry = pop(reorder);
+      reorder->expectedFile = entry.request.file;
+      reorder->expectedSeq = entry.request.seq + 1;
+      emit(reorder, &entry, 0);
+      drain(reorder);
+    }
+  }
+
+  pthread_mutex_unlock(&reorder->lock);
+}
+
+// Definition of reorder_eof method.
+void reorder_eof(Reorder* reorder, int file, long lines)
+{
+  pthread_mutex_lock(&reorder->lock);
+  reorder->lines[file] = lines;
+  drain(reorder);
+  pthread_mutex_unlock(&reorder->lock);
+}
+
+// Definition of reorder_finish method.
+long reorder_finish(Reorder* reorder)
+{
+  pthread_mutex_lock(&reorder->lock);
+  while(reorder->held > 0){
+    ReorderEntry entry = pop(reorder);
+    emit(reorder, &entry, 0);
+  }
+  long unordered = reorder->unordered;
+  pthread_mutex_unlock(&reorder->lock);
+
+  pthread_mutex_destroy(&reorder->lock);
+  pthread_cond_destroy(&reorder->moved);
+  free(reorder->lines);
+  free(reorder->heap);
+  return unordered;
+}
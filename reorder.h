@@ -0,0 +1,104 @@
+/*
+ *  CSCI-3753 Design and Analysis of Operating Systems, PA3 Bounded Buffer Problem - reorder header file.
+ *
+ *  Resolvers finish hostnames in whatever order their lookups happen to complete.  For ordered output, each finished
+ *  line is handed to a reorder buffer instead of being written straight away.  The buffer knows which line comes next
+ *  in input order (input files in the order given, lines in file order) and holds on to anything that arrives early
+ *  until everything before it has been written.
+ *
+ *  Requesters read different files at the same time, so lines from later files are read long before their turn.  To
+ *  keep them from filling the window, a requester is admitted to the window before it passes each line on, and waits
+ *  while its line is too far ahead of the next one due.  Only when the stream hasn't moved for REORDER_STALL_MS do
+ *  requesters stop waiting; the window then overflows, the earliest held line is written anyway and flagged as out of
+ *  order, and the stream carries on from there, so one very slow lookup can't stall the whole run.
+ */
+
+#ifndef REORDER_H
+#define REORDER_H
+
+#include <pthread.h>
+#include <netinet/in.h>
+#include "ts_buffer.h"
+
+#define DEFAULT_REORDER_WINDOW 4096
+
+// How long requesters wait on a full window before deciding the line due next is stuck in a lookup.
+#define REORDER_STALL_MS 2000
+
+/*
+ *  Writes one line of output: the request's hostname, found from its ID, and its address or NOT_RESOLVED.  ordered is
+ *  zero if the line is being written out of input order.  An address of NULL marks an input line the last run already
+ *  wrote, which only needs its progress recorded.
+ */
+typedef void (*ReorderEmit)(void* ctx, Request* request, const char* ip, int ordered);
+
+// A held line.  Its hostname is in the intern table, so only its address is kept; an empty one stands for NULL.
+typedef struct ReorderEntry{
+  Request request;
+  char ip[INET6_ADDRSTRLEN];
+} ReorderEntry;
+
+typedef struct Reorder{
+  pthread_mutex_t lock;
+  pthread_cond_t moved;
+  ReorderEmit emit;
+  void* ctx;
+  int total;
+  long* lines;
+  int expectedFile;
+  long expectedSeq;
+  int window;
+  long pending;
+  int stalledFile;
+  long stalledSeq;
+  int held;
+  ReorderEntry* heap;
+  long unordered;
+} Reorder;
+
+/*
+ *  Prototype of reorder_init method.
+ *  This method initializes a reorder buffer and allocates its window.
+ *  Params:  the struct to initialize, the number of input files, the most lines to hold at once, the function that writes
+ *  a line and the context it is passed.
+ *  Returns 0 on success, -1 on failure.
+ */
+int reorder_init(Reorder* reorder, int total, int window, ReorderEmit emit, void* ctx);
+
+/*
+ *  Prototype of reorder_admit method.
+ *  This method admits a line that has just been read to the window, before it is passed on.  It blocks while the line is
+ *  more than half the window ahead of the next line due in its file, or, for a line of a later file, while half the
+ *  window is already pending; unless the stream has stalled for REORDER_STALL_MS.  Every admitted line must later be
+ *  submitted.
+ *  Params:  the reorder buffer, the index of the line's input file, its line number.
+ */
+void reorder_admit(Reorder* reorder, int file, long seq);
+
+/*
+ *  Prototype of reorder_submit method.
+ *  This method hands a finished line to the reorder buffer.  The line, and any held lines it unblocks, are written before
+ *  this returns if they are next in input order; otherwise the line is held.  It never blocks on other resolvers.
+ *  Params:  the reorder buffer, the request the line belongs to, its address or NOT_RESOLVED (copied; NULL for a line the
+ *  last run already wrote).
+ */
+void reorder_submit(Reorder* reorder, Request* request, const char* ip);
+
+/*
+ *  Prototype of reorder_eof method.
+ *  This method tells the reorder buffer how many lines an input file turned out to have, so that output can move on to
+ *  the next file once they have all been written.  It must be called for every input file, including those that could
+ *  not be opened or needed no work, which have 0 lines.
+ *  Params:  the reorder buffer, the index of the input file, the number of lines read from it.
+ */
+void reorder_eof(Reorder* reorder, int file, long lines);
+
+/*
+ *  Prototype of reorder_finish method.
+ *  This method writes anything still held once every resolver has finished, and frees the window.  Lines can only be left
+ *  over if some earlier line never arrived, so they are flagged as out of order.
+ *  Returns the number of lines written out of order over the whole run.
+ */
+long reorder_finish(Reorder* reorder);
+
+#endif
@@ -0,0 +1,77 @@
+#!/bin/sh
+#
+#  CSCI-3753 Design and Analysis of Operating Systems, PA3 Bounded Buffer Problem - native DNS client check.
+#
+#  Starts tools/stubdns.py on the loopback interface and runs multi-lookup --dns-server against it: first a handful of
+#  names that each exercise one kind of answer (NXDOMAIN, SERVFAIL, truncation and the retry over TCP, AAAA only, CNAME,
+#  a dropped packet, an address literal), then a throughput run of many names with a share of packets dropped.
+#
+#  Usage: tools/stub-check.sh [NAMES [DROP_PERCENT [PORT]]]    (run from the top of the tree, after make)
+#
+
+NAMES=${1:-20000}
+DROP=${2:-1}
+PORT=${3:-15353}
+DIR=$(mktemp -d)
+STATUS=0
+
+python3 tools/stubdns.py --port="$PORT" --drop=0 > "$DIR/stub.log" 2>&1 &
+STUB=$!
+trap 'kill $STUB 2>/dev/null; wait $STUB 2>/dev/null; rm -rf "$DIR"' EXIT
+sleep 1
+
+# One name of each kind, and what its serviced line must look like.
+cat > "$DIR/kinds.txt" <<EOF
+example.com
+nxhost.com
+servfail.com
+big.com
+v6only.com
+alias.com
+slow.com
+127.0.0.1
+EOF
+
+./multi-lookup --dns-server=127.0.0.1:"$PORT" 1 1 "$DIR/results.txt" "$DIR/serviced.txt" "$DIR/kinds.txt" > /dev/null 2>&1
+
+check() {
+    if grep -Eq "$2" "$DIR/serviced.txt"; then
+	echo "ok    $1"
+    else
+	echo "FAIL  $1"
+	STATUS=1
+    fi
+}
+check "A record"                 '^example\.com, 10\.'
+check "NXDOMAIN"                 '^nxhost\.com, NOT_RESOLVED$'
+check "SERVFAIL"                 '^servfail\.com, NOT_RESOLVED$'
+check "truncated, retried on TCP" '^big\.com, 10\.'
+check "AAAA fallback"            '^v6only\.com, [0-9a-f]*:'
+check "CNAME then A"             '^alias\.com, 10\.'
+check "first packet dropped"     '^slow\.com, 10\.'
+check "address literal"          '^127\.0\.0\.1, 127\.0\.0\.1$'
+
+# Throughput with lost packets: restart the stub dropping a share of queries.
+kill $STUB; wait $STUB 2>/dev/null
+python3 tools/stubdns.py --port="$PORT" --drop="$DROP" > "$DIR/stub.log" 2>&1 &
+STUB=$!
+sleep 1
+
+i=0
+while [ $i -lt "$NAMES" ]; do
+    echo "host$i.example.com"
+    i=$((i + 1))
+done > "$DIR/many.txt"
+
+START=$(date +%s.%N)
+./multi-lookup --dns-server=127.0.0.1:"$PORT" 1 1 "$DIR/results.txt" "$DIR/serviced.txt" "$DIR/many.txt" > /dev/null 2>&1
+END=$(date +%s.%N)
+LINES=$(wc -l < "$DIR/serviced.txt")
+RESOLVED=$(grep -vc NOT_RESOLVED "$DIR/serviced.txt")
+echo "$LINES of $NAMES names serviced, $RESOLVED resolved, with $DROP% of packets dropped, one resolver:" \
+     "$(echo "$NAMES $START $END" | awk '{printf "%.0f names/s", $1 / ($3 - $2)}')"
+if [ "$LINES" -ne "$NAMES" ]; then
+    STATUS=1
+fi
+
+exit $STATUS
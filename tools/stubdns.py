@@ -0,0 +1,160 @@
+#!/usr/bin/env python3
+#
+#  CSCI-3753 Design and Analysis of Operating Systems, PA3 Bounded Buffer Problem - loopback stub DNS server.
+#
+#  A tiny authoritative-for-everything DNS server for exercising multi-lookup's native client (--dns-server) without
+#  touching the real network.  It listens on UDP and TCP on 127.0.0.1, and answers every A query with an address made
+#  from a hash of the name, so the same name always gets the same address.  What else it does depends on the name:
+#
+#    contains "nx"        NXDOMAIN
+#    contains "servfail"  SERVFAIL
+#    contains "big"       over UDP, an empty answer with the TC bit set; over TCP, 61 A records
+#    contains "v6only"    no A record, only an AAAA record
+#    contains "alias"     a CNAME to target.com ahead of the address
+#    contains "slow"      the first UDP packet of every query is dropped, so it is only answered when it is sent again
+#
+#  --drop=PERCENT drops that share of all other UDP queries at random, to see how a resolver copes with lost replies.
+#  --drop-for=SECONDS drops every UDP query for that long after starting, so that lookups pile up in flight.
+#
+
+import argparse
+import hashlib
+import random
+import signal
+import socket
+import struct
+import threading
+import time
+
+TYPE_A = 1
+TYPE_CNAME = 5
+TYPE_AAAA = 28
+RCODE_SERVFAIL = 2
+RCODE_NXDOMAIN = 3
+
+
+def read_name(packet, offset):
+    """Return the question name starting at offset, and the offset just past it."""
+    labels = []
+    while packet[offset]:
+        length = packet[offset]
+        labels.append(packet[offset + 1:offset + 1 + length].decode('ascii', 'replace'))
+        offset += length + 1
+    return '.'.join(labels), offset + 1
+
+
+def record(rtype, data):
+    """A resource record for the question name (a pointer to offset 12), class IN, TTL 60."""
+    return b'\xc0\x0c' + struct.pack('!HHIH', rtype, 1, 60, len(data)) + data
+
+
+def answer(query, tcp):
+    """Build the reply to one query."""
+    ident = struct.unpack('!H', query[:2])[0]
+    name, offset = read_name(query, 12)
+    qtype = struct.unpack('!H', query[offset:offset + 2])[0]
+    question = query[12:offset + 4]
+    name = name.lower()
+    digest = hashlib.md5(name.encode()).digest()
+
+    rcode = 0
+    truncated = False
+    records = []
+    if 'nx' in name:
+        rcode = RCODE_NXDOMAIN
+    elif 'servfail' in name:
+        rcode = RCODE_SERVFAIL
+    else:
+        if 'alias' in name:
+            records.append(record(TYPE_CNAME, b'\x06target\x03com\x00'))
+        if 'v6only' in name:
+            if qtype == TYPE_AAAA:
+                records.append(record(TYPE_AAAA, digest))
+        elif qtype == TYPE_A:
+            records.append(record(TYPE_A, bytes([10, digest[0], digest[1], digest[2]])))
+        if 'big' in name and qtype == TYPE_A:
+            if tcp:
+                records += [record(TYPE_A, bytes([10, 1, 1, i])) for i in range(60)]
+            else:
+                truncated = True
+                records = []
+
+    flags = 0x8180 | (0x0200 if truncated else 0) | rcode
+    header = struct.pack('!HHHHHH', ident, flags, 1, len(records), 0, 0)
+    return header + question + b''.join(records)
+
+
+def serve_udp(port, drop, drop_until, stats):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind(('127.0.0.1', port))
+    dropped_once = set()
+    while True:
+        query, client = sock.recvfrom(512)
+        stats['udp'] += 1
+        if time.monotonic() < drop_until:
+            stats['dropped'] += 1
+            continue
+        try:
+            name, _ = read_name(query, 12)
+        except IndexError:
+            continue
+        if 'slow' in name and (name, query[:2]) not in dropped_once:
+            dropped_once.add((name, query[:2]))
+            stats['dropped'] += 1
+            continue
+        if drop > 0 and random.random() * 100 < drop:
+            stats['dropped'] += 1
+            continue
+        sock.sendto(answer(query, False), client)
+
+
+def serve_tcp_connection(conn, stats):
+    with conn:
+        prefix = conn.recv(2)
+        if len(prefix) < 2:
+            return
+        length = struct.unpack('!H', prefix)[0]
+        query = b''
+        while len(query) < length:
+            chunk = conn.recv(length - len(query))
+            if not chunk:
+                return
+            query += chunk
+        reply = answer(query, True)
+        stats['tcp'] += 1
+        conn.sendall(struct.pack('!H', len(reply)) + reply)
+
+
+def serve_tcp(port, stats):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.bind(('127.0.0.1', port))
+    sock.listen(64)
+    while True:
+        conn, _ = sock.accept()
+        threading.Thread(target=serve_tcp_connection, args=(conn, stats), daemon=True).start()
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Loopback stub DNS server for testing multi-lookup --dns-server.')
+    parser.add_argument('--port', type=int, default=5353, help='port to listen on (default 5353)')
+    parser.add_argument('--drop', type=float, default=0, help='percentage of UDP queries to drop at random')
+    parser.add_argument('--drop-for', type=float, default=0, help='drop every UDP query for this many seconds after starting')
+    parser.add_argument('--seed', type=int, default=3753, help='seed for the random drops')
+    args = parser.parse_args()
+
+    # Stop cleanly, printing the counts, when killed as well as on ^C.
+    signal.signal(signal.SIGTERM, signal.default_int_handler)
+    random.seed(args.seed)
+    stats = {'udp': 0, 'tcp': 0, 'dropped': 0}
+    threading.Thread(target=serve_tcp, args=(args.port, stats), daemon=True).start()
+    try:
+        serve_udp(args.port, args.drop, time.monotonic() + args.drop_for, stats)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        print('stubdns: %(udp)d UDP queries (%(dropped)d dropped), %(tcp)d TCP queries' % stats)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,63 @@
+#!/bin/sh
+#
+#  CSCI-3753 Design and Analysis of Operating Systems, PA3 Bounded Buffer Problem - worker process crash check.
+#
+#  Runs multi-lookup with one worker process of MAX_RESOLVER_THREADS resolvers against tools/stubdns.py, which drops
+#  every query for the first few seconds so that every resolver's window fills up with lookups in flight.  While they are
+#  stuck, the worker is killed, and then its replacement is killed too, holding both a full window of its own and what
+#  the first worker left it.  Every hostname must still come out in the serviced log exactly once.
+#
+#  Usage: tools/worker-crash-check.sh [NAMES [PORT]]    (run from the top of the tree, after make)
+#
+
+NAMES=${1:-20000}
+PORT=${2:-15354}
+RESOLVERS=10
+DIR=$(mktemp -d)
+STATUS=0
+
+python3 tools/stubdns.py --port="$PORT" --drop-for=4 > "$DIR/stub.log" 2>&1 &
+STUB=$!
+trap 'kill $STUB 2>/dev/null; wait $STUB 2>/dev/null; rm -rf "$DIR"' EXIT
+sleep 0.5
+
+i=0
+while [ $i -lt "$NAMES" ]; do
+    echo "host$i.example.com"
+    i=$((i + 1))
+done > "$DIR/many.txt"
+
+./multi-lookup --worker-processes=1 --dns-server=127.0.0.1:"$PORT" 1 "$RESOLVERS" \
+    "$DIR/results.txt" "$DIR/serviced.txt" "$DIR/many.txt" > /dev/null 2> "$DIR/stderr.txt" &
+LOOKUP=$!
+
+# The worker is the only child of multi-lookup; kill it, then whichever worker replaced it.
+kill_worker() {
+    WORKER=$(pgrep -P $LOOKUP | head -n 1)
+    if [ -n "$WORKER" ]; then
+	kill -9 "$WORKER"
+	echo "killed worker $WORKER"
+    else
+	echo "FAIL  no worker process to kill"
+	STATUS=1
+    fi
+}
+sleep 1
+kill_worker
+sleep 1.5
+kill_worker
+
+wait $LOOKUP
+LINES=$(wc -l < "$DIR/serviced.txt")
+UNIQUE=$(cut -d, -f1 "$DIR/serviced.txt" | sort -u | wc -l)
+GIVEN_UP=$(grep -c "Giving up" "$DIR/stderr.txt")
+echo "$LINES lines in the serviced log for $NAMES names, $UNIQUE of them different, $GIVEN_UP given up on"
+grep WARNING "$DIR/stderr.txt"
+if [ "$LINES" -ne "$NAMES" ] || [ "$UNIQUE" -ne "$NAMES" ] || [ "$GIVEN_UP" -ne 0 ]; then
+    echo "FAIL  every hostname must be serviced"
+    STATUS=1
+else
+    echo "ok    every hostname serviced"
+fi
+
+exit $STATUS
@@ -0,0 +1,214 @@
+/*
+ *  CSCI-3753 Design and Analysis of Operating Systems PA3 Bounded Buffer problem - trace definition.
+ */
+
+#include <pthread.h>
+#include <string.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include "trace.h"
+
+typedef struct TraceEvent{
+  long long ts;
+  long long dur;
+  long seq;
+  int file;
+  int phase;
+  char host[TRACE_HOST_LENGTH];
+} TraceEvent;
+
+// One thread's events.  Only the owning thread writes to it, and only after it has been joined is it read.
+typedef struct TraceRing{
+  struct TraceRing* next;
+  const char* role;
+  int tid;
+  unsigned long count;
+  TraceEvent events[TRACE_RING_SIZE];
+} TraceRing;
+
+static const char* phaseNames[] = {"read", "enqueue", "dequeue", "lookup", "written"};
+
+static char* traceName;
+static int traceSample;
+static long long traceStart;
+
+// Every ring is linked in here when its thread records its first event; the lock is only taken then and at export.
+static pthread_mutex_t ringsLock = PTHREAD_MUTEX_INITIALIZER;
+static TraceRing* rings;
+static int numRings;
+static __thread TraceRing* ring;
+static __thread const char* threadRole;
+
+// Find the calling thread's ring, creating and registering it the first time.
+static TraceRing* own_ring()
+{
+  if(ring == NULL){
+    ring = calloc(1, sizeof(TraceRing));
+    if(ring == NULL){
+      return NULL;
+    }
+    ring->role = threadRole != NULL ? threadRole : "main";
+    pthread_mutex_lock(&ringsLock);
+    ring->tid = ++numRings;
+    ring->next = rings;
+    rings = ring;
+    pthread_mutex_unlock(&ringsLock);
+  }
+  return ring;
+}
+
+// Write a string as a JSON string literal.
+static void write_json_string(FILE* fd, const char* str)
+{
+  fputc('"', fd);
+  for(const unsigned char* p = (const unsigned char *) str; *p != '\0'; p++){
+    if(*p == '"' || *p == '\\'){
+      fprintf(fd, "\\%c", *p);
+    }else if(*p < 0x20){
+      fprintf(fd, "\\u%04x", *p);
+    }else{
+      fputc(*p, fd);
+    }
+  }
+  fputc('"', fd);
+}
+
+// Definition of trace_init method.
+int trace_init(char* name, int sample)
+{
+  traceName = name;
+  traceSample = sample > 0 ? sample : 1;
+  traceStart = trace_now();
+  return 0;
+}
+
+// Definition of trace_sampled method.
+int trace_sampled(int file, long seq)
+{
+  if(traceName == NULL){
+    return 0;
+  }
+
+  // Mix the position up so that sampled hostnames are spread evenly rather than every Nth line of every file.
+  unsigned long long hash = ((unsigned long long) file * 0x9E3779B97F4A7C15ULL) ^ ((unsigned long long) seq * 0xC2B2AE3D27D4EB4FULL);
+  hash ^= hash >> 29;
+  return hash % traceSample == 0;
+}
+
+// Definition of trace_thread method.
+void trace_thread(const char* role)
+{
+  threadRole = role;
+  if(ring != NULL){
+    ring->role = role;
+  }
+}
+
+// Definition of trace_now method.
+long long trace_now()
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (long long) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+// Definition of trace_event method.
+void trace_event(int phase, Request* request, const char* hostname, long long start)
+{
+  TraceRing* own = own_ring();
+  if(own == NULL){
+    return;
+  }
+
+  long long now = trace_now();
+  TraceEvent* event = &own->events[own->count % TRACE_RING_SIZE];
+  event->ts = start > 0 ? start : now;
+  event->dur = start > 0 ? now - start : 0;
+  event->seq = request->seq;
+  event->file = request->file;
+  event->phase = phase;
+  strncpy(event->host, hostname, TRACE_HOST_LENGTH - 1);
+  event->host[TRACE_HOST_LENGTH - 1] = '\0';
+  own->count++;
+}
+
+// Definition of trace_forget method.
+void trace_forget()
+{
+  // The inherited rings belong to threads that don't exist in this process; just let go of them.
+  rings = NULL;
+  numRings = 0;
+  ring = NULL;
+}
+
+// Definition of trace_export method.
+int trace_export(int worker)
+{
+  if(traceName == NULL){
+    return 0;
+  }
+
+  char name[PATH_MAX];
+  if(worker){
+    snprintf(name, sizeof(name), "%s.%d", traceName, getpid());
+  }else{
+    snprintf(name, sizeof(name), "%s", traceName);
+  }
+
+  FILE* fd = fopen(name, "w");
+  if(fd == NULL){
+    printf("%s%s%s\n", "ERROR: Failed to open trace file ", name, "!");
+    return -1;
+  }
+
+  int pid = getpid();
+  int first = 1;
+  fprintf(fd, "{\"traceEvents\":[\n");
+  pthread_mutex_lock(&ringsLock);
+  for(TraceRing* r = rings; r != NULL; r = r->next){
+    fprintf(fd, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s %d\"}}", first ? "" : ",\n", pid, r->tid, r->role, r->tid);
+    first = 0;
+
+    // Only the last TRACE_RING_SIZE events survive in a ring that wrapped.
+    unsigned long oldest = r->count > TRACE_RING_SIZE ? r->count - TRACE_RING_SIZE : 0;
+    for(unsigned long i = oldest; i < r->count; i++){
+      TraceEvent* event = &r->events[i % TRACE_RING_SIZE];
+      double ts = (double)(event->ts - traceStart) / 1000;
+      long long id = ((long long) event->file << 32) | (event->seq & 0xFFFFFFFFLL);
+
+      if(event->phase == TRACE_ENQUEUE || event->phase == TRACE_DEQUEUE || event->phase == TRACE_LOOKUP){
+	fprintf(fd, ",\n{\"name\":\"%s\",\"cat\":\"hostname\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d,\"args\":{\"host\":", phaseNames[event->phase], ts, (double) event->dur / 1000, pid, r->tid);
+      }else{
+	fprintf(fd, ",\n{\"name\":\"%s\",\"cat\":\"hostname\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d,\"args\":{\"host\":", phaseNames[event->phase], ts, pid, r->tid);
+      }
+      write_json_string(fd, event->host);
+      fprintf(fd, ",\"file\":%d,\"line\":%ld}}", event->file, event->seq);
+
+      // Draw an arrow from the enqueue to the dequeue, which is the time the hostname spent waiting in the shared array.
+      // The enqueue starts before the hostname goes in, and the dequeue once it is out, so it never points back.  Both
+      // ends are at the start of their step's slice, which is what a viewer binds them to.
+      if(event->phase == TRACE_ENQUEUE || event->phase == TRACE_DEQUEUE){
+	fprintf(fd, ",\n{\"name\":\"queued\",\"cat\":\"hostname\",\"ph\":\"%s\",\"id\":%lld,\"ts\":%.3f,\"pid\":%d,\"tid\":%d%s}",
+		event->phase == TRACE_ENQUEUE ? "s" : "f", id, ts, pid, r->tid, event->phase == TRACE_DEQUEUE ? ",\"bp\":\"e\"" : "");
+      }
+    }
+  }
+  fprintf(fd, "\n]}\n");
+
+  // The rings have all been written out, so they can go.
+  while(rings != NULL){
+    TraceRing* next = rings->next;
+    free(rings);
+    rings = next;
+  }
+  ring = NULL;
+  pthread_mutex_unlock(&ringsLock);
+
+  if(fclose(fd) != 0){
+    printf("%s%s%s\n", "ERROR: Failed to write trace file ", name, "!");
+    return -1;
+  }
+  return 0;
+}
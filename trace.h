@@ -0,0 +1,86 @@
+/*
+ *  CSCI-3753 Design and Analysis of Operating Systems, PA3 Bounded Buffer Problem - trace header file.
+ *
+ *  Optional per-hostname tracing.  A sample of hostnames is stamped at every step of its trip through multi-lookup:
+ *  read by a requester, enqueued, dequeued by a resolver, looked up, and written to the serviced log.  Each thread
+ *  records its events into a ring buffer of its own, so recording never takes a lock or touches another thread's
+ *  memory; the rings are only read once every thread has been joined, when they are exported as a Chrome trace-event
+ *  JSON file that can be opened in chrome://tracing or Perfetto.  Flow arrows link each hostname's enqueue on its
+ *  requester thread to its dequeue on its resolver thread, so queueing delay and lookup time can be told apart.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+#include "ts_buffer.h"
+
+// Events each thread keeps.  Once a thread's ring is full, its oldest events are overwritten.
+#define TRACE_RING_SIZE 16384
+#define TRACE_HOST_LENGTH 32
+#define DEFAULT_TRACE_SAMPLE 100
+
+// The steps of a hostname's trip that are recorded.
+#define TRACE_READ 0
+#define TRACE_ENQUEUE 1
+#define TRACE_DEQUEUE 2
+#define TRACE_LOOKUP 3
+#define TRACE_WRITTEN 4
+
+/*
+ *  Prototype of trace_init method.
+ *  This method turns tracing on.  Until it is called, trace_sampled always says no and nothing is recorded.
+ *  Params:  the name of the file to export to, and N to trace one hostname in every N.
+ *  Returns 0 on success.
+ */
+int trace_init(char* name, int sample);
+
+/*
+ *  Prototype of trace_sampled method.
+ *  This method decides whether a hostname is traced.  The decision depends only on where the hostname came from, so it is
+ *  made once by the requester and carried along in the Request.
+ *  Params:  the hostname's input file index and line number.
+ *  Returns nonzero if the hostname should be traced.
+ */
+int trace_sampled(int file, long seq);
+
+/*
+ *  Prototype of trace_thread method.
+ *  This method names the calling thread in the exported trace.
+ *  Params:  a name such as "requester" or "resolver", which must outlive the trace.
+ */
+void trace_thread(const char* role);
+
+/*
+ *  Prototype of trace_now method.
+ *  Returns the current time in nanoseconds, for timing a step that is recorded once it ends.
+ */
+long long trace_now();
+
+/*
+ *  Prototype of trace_event method.
+ *  This method records one step of a traced hostname's trip in the calling thread's ring.  Steps that take time (the
+ *  enqueue, which waits for room in the shared array, the dequeue, from taking the hostname out to recording it, and the
+ *  lookup) pass the time they started; every other step happens at the moment it is recorded.
+ *  Params:  the step, the hostname's request, the hostname, and the start time from trace_now (or 0 for an instant step).
+ */
+void trace_event(int phase, Request* request, const char* hostname, long long start);
+
+/*
+ *  Prototype of trace_forget method.
+ *  This method is called in a newly forked worker process, which inherits copies of its parent's rings.  It drops them,
+ *  so the worker only exports its own events.
+ */
+void trace_forget();
+
+/*
+ *  Prototype of trace_export method.
+ *  This method writes every thread's events to the trace file.  It must only be called once every thread that recorded
+ *  events has been joined.  A worker process writes to the trace file's name followed by ".<pid>" instead, so that each
+ *  process produces a file of its own.
+ *  Params:  nonzero if called from a worker process.
+ *  Returns 0 on success or if tracing is off, -1 if the file could not be written.
+ */
+int trace_export(int worker);
+
+#endif
@@ -6,119 +6,118 @@
  *  defines the methods of a thread-safe bounded buffer: init, read, write, destroy.
  */
 
+#include <sys/mman.h>
 #include "ts_buffer.h"
+#include "bounded_buffer.h"
+
+// The array is a bounded buffer of Requests.  Everything it needs lives in the one struct, so that it can be placed in
+// either private or shared memory.
+DEFINE_BOUNDED_BUFFER(SharedArray, Request, MAX_ARRAY_SIZE)
+
+static SharedArray* array;
 
 // Definition of init method for ts_array.
 int init()
 {
-  urls = 0;
+  // Map the array fresh, rather than using malloc'd memory that another CPU may already have touched.
+  array = mmap(NULL, sizeof(*array), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
 
-  // Allocate memory for each element of the buffer
-  for(int i=0; i<MAX_ARRAY_SIZE;i++)
+  // If memory cannot be allocated for the buffer, return error state.
+  if (array == MAP_FAILED)
   {
-    buffer[i] = malloc(MAX_NAME_LENGTH * sizeof(char));
-
-    // If memory cannot be allocated for any string in buffer, return error state.
-    if (buffer[i] == NULL)
-    {
-      return -1;
-    }
+    array = NULL;
+    return -1;
   }
 
+  // Touch every page now, so that they are placed on this thread's NUMA node.
+  memset(array, '\0', sizeof(*array));
+
   // Initialize mutex, readBlock, writeBlock semaphores.
-  int err = pthread_mutex_init(&mutex, NULL);
-  readBlock = (pthread_cond_t) PTHREAD_COND_INITIALIZER;
-  writeBlock = (pthread_cond_t) PTHREAD_COND_INITIALIZER;
+  int err = SharedArray_init(array, 0);
 
   // If any of the semaphores cannot be initialized, return error state.
   if(err != 0)
   {
-    for (int i = 0; i < MAX_ARRAY_SIZE; i++){
-      free(buffer[i]);
-    }
+    munmap(array, sizeof(*array));
+    array = NULL;
     return -1;
   }else
   {
     return 0;
   }
-  
+
 }
 
-// Definition for read method of ts_array.
-int ts_read(char* hostname)
+// Definition of init_shared method for ts_array.
+int init_shared()
 {
-
-  // If the array is empty, block on readBlock semaphore.
-  pthread_mutex_lock(&mutex);
-  while(urls == 0)
-  {
-    pthread_cond_wait(&readBlock, &mutex);
+  // An anonymous shared mapping has no name to leak: it goes away with the last process that has it mapped, however
+  // that process exits.  The memset both zeroes it and first-touches it on this NUMA node.
+  array = mmap(NULL, sizeof(*array), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if(array == MAP_FAILED){
+    array = NULL;
+    return -1;
   }
+  memset(array, '\0', sizeof(*array));
 
-  
-  strcpy(hostname, buffer[urls-1]);
-  memset(buffer[urls-1], '\0', MAX_NAME_LENGTH);\
-  urls--;
-
-  if(urls == MAX_ARRAY_SIZE-1){
-    pthread_cond_broadcast(&writeBlock);
+  if(SharedArray_init(array, 1) != 0){
+    munmap(array, sizeof(*array));
+    array = NULL;
+    return -1;
   }
 
-  // Unlock the mutex when the hostname has been removed and urls decremented.
-  pthread_mutex_unlock(&mutex);
-  
   return 0;
 }
 
-// Definition for write method of ts_array.
-int ts_write(char* data)
+// Definition for read method of ts_array.
+int ts_read(Request* request)
 {
-  // Strip newline character from the input data.
-  char *newline;
-  newline = strchr(data, '\n');
-  if(newline != NULL)
-  {
-    *newline = '\0';
-  }
+  // Hostnames are read in the same order they were written; blocks while the array is empty and still open.
+  return SharedArray_get(array, request);
+}
 
-  pthread_mutex_lock(&mutex);
-  // If the array is full, block on writeBlock semaphore.
-  while(urls == MAX_ARRAY_SIZE){
-    pthread_cond_wait(&writeBlock, &mutex);
-  }
+// Definition for try_read method of ts_array.
+int ts_try_read(Request* request)
+{
+  return SharedArray_try_get(array, request);
+}
 
-  
-  strcpy(buffer[urls], data);
-  urls++;
+// Definition for write method of ts_array.
+int ts_write(Request* request)
+{
+  // Blocks while the array is full.
+  return SharedArray_put(array, request);
+}
 
-  if(urls - 1 == 0){
-    pthread_cond_broadcast(&readBlock);
-  }
-  
-  // Unlock the mutex lock when the hostname has been written to the shared array and urls incremented.
-  pthread_mutex_unlock(&mutex);  
-  
-  return 0;
+// Definition of ts_close method of ts_array.
+int ts_close()
+{
+  // Wake every blocked reader, so that readers waiting on an empty array can exit.
+  return SharedArray_close(array);
+}
+
+// Definition of is_closed method of ts_array.
+int is_closed()
+{
+  return SharedArray_is_closed(array);
 }
 
 // Definition of get_num_elements.  Pretty self-evident what this method does.
 int get_num_elements()
 {
-  return urls;
+  return SharedArray_count(array);
 }
 
 // Definition of destroy method of ts_array.
 int destroy()
 {
-  // Free resources allocated to the bounded buffer.
-  for(int i=0;i<MAX_ARRAY_SIZE;i++)
-  {
-    free(buffer[i]);
+  if(array == NULL){
+    return -1;
   }
 
-  // Destroy the ts_array semaphores.
-  pthread_mutex_destroy(&mutex);
-  pthread_cond_destroy(&readBlock);
-  pthread_cond_destroy(&writeBlock);
+  // Destroy the ts_array semaphores, and free resources allocated to the bounded buffer.
+  SharedArray_destroy(array);
+  munmap(array, sizeof(*array));
+  array = NULL;
   return 0;
 }
@@ -4,46 +4,92 @@
  *  Created by Jeff Colgan; March 23, 2021.
  */
 
+#ifndef TS_BUFFER_H
+#define TS_BUFFER_H
+
 #include <semaphore.h>
 #include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 
 #define MAX_ARRAY_SIZE 10
 #define MAX_NAME_LENGTH 255
 
-unsigned int urls;
-char *buffer[MAX_ARRAY_SIZE];
-pthread_cond_t readBlock;
-pthread_cond_t writeBlock;
-pthread_mutex_t mutex;
+/*
+ *  One hostname on its way from a requester to a resolver, together with where it came from: the index of its input
+ *  file in the FileList, its line number within the part of the file read by this run, and the byte offsets of the
+ *  start and end of its line.  traced is set if the hostname was sampled for tracing, and requeued counts the worker
+ *  processes that died while resolving it.  The hostname itself is carried as its ID in the intern table, so a request is
+ *  a few words rather than a whole name.
+ */
+typedef struct Request{
+  uint32_t host;
+  int file;
+  long seq;
+  long offset;
+  long end;
+  int traced;
+  int requeued;
+} Request;
 
 /*
  *  This method initializes the shared array and allocates the necessary memory.  It must be successfully
  *  called before any requester or resolver threads can be generated.
+ *  The hostname slots are mapped fresh and zeroed here, so they are first touched (and therefore placed) on
+ *  the NUMA node of whichever CPU the calling thread is pinned to.
  *  Returns 0 on success and nonzero on failure.
  */
 int init();
 
+/*
+ *  This method initializes the shared array in anonymous shared memory instead of private memory, so that it is shared
+ *  with child processes, which inherit the mapping across fork.  The mutex and condition variables are process-shared,
+ *  and the mutex is robust: if a process dies while holding it, the next process to lock it recovers it instead of
+ *  deadlocking.  It is used in place of init.
+ *  Returns 0 on success and nonzero on failure.
+ */
+int init_shared();
+
 /*
  *  This method provides synchronized access to the shared array to resolver threads, which take one url from
- *  the shared resource, consuming the values in the array.
+ *  the shared resource, consuming the values in the array.  Urls are consumed in the order they were written.
  *  If the array is empty, resolver threads should block until there is at least one piece of data in the array to be
- *  consumed.
- *  Params: the variable to be written to by the shared array.
- *  Returns 0 success.
+ *  consumed, or until the array is closed.
+ *  Params: the request to be written to by the shared array.
+ *  Returns 0 success, nonzero if the array has been closed and there is nothing left to consume.
  */
-int ts_read(char* hostname);
+int ts_read(Request* request);
+
+/*
+ *  This method is the same as ts_read, except that it never blocks.  Resolvers use it to top up their window of
+ *  lookups in flight.
+ *  Params: the request to be written to by the shared array.
+ *  Returns 0 on success, nonzero if the array is empty right now.
+ */
+int ts_try_read(Request* request);
 
 /*
  *  This method provides synchronized access to the shared array to requester threads, which produce values to
  *  be placed on the array.
  *  If the array is full, requester threads should block until the array has room for at least one piece of produced
  *  data to be placed in the array.
- *  Params: the data to be placed into the shared array.
+ *  Params: the request to be placed into the shared array.
  *  Returns 0 on success, nonzero on failure.
  */
-int ts_write(char* data);
+int ts_write(Request* request);
+
+/*
+ *  This method marks the array as closed once every requester has finished writing to it.  Resolvers blocked on an
+ *  empty array are woken, and ts_read fails as soon as the remaining urls have been consumed.
+ *  Returns 0 on success.
+ */
+int ts_close();
+
+/*
+ *  This is a simple getter method which tells whether ts_close has been called, by this or any other process.
+ */
+int is_closed();
 
 /*
  *  This is a simple getter method, which allows requester/resolver threads to get the number of hostnames currently stored
@@ -57,3 +103,5 @@ int get_num_elements();
  *  Returns 0 upon success, nonzero on failure.
  */
 int destroy();
+
+#endif
@@ -12,6 +12,16 @@
  *  
  */
 
+/* Needed for sendmmsg and recvmmsg */
+#define _GNU_SOURCE
+
+#include <ctype.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/random.h>
+
 #include "util.h"
 
 int dnslookup(const char* hostname, char* firstIPstr, int maxSize){
@@ -35,7 +45,7 @@ int dnslookup(const char* hostname, char* firstIPstr, int maxSize){
     if(addrError){
 	fprintf(stderr, "Error looking up Address: %s\n",
 		gai_strerror(addrError));
-	return UTIL_FAILURE;
+	return addrError == EAI_AGAIN ? UTIL_TRYAGAIN : UTIL_FAILURE;
     }
     /* Loop Through result Linked List */
     for(result=headresult; result != NULL; result = result->ai_next){
@@ -83,3 +93,645 @@ int dnslookup(const char* hostname, char* firstIPstr, int maxSize){
 
     return UTIL_SUCCESS;
 }
+
+/* Native client.  Queries are built and parsed here by
+ * hand, following RFC 1035 */
+
+#define DNS_UDP_SIZE 512
+#define DNS_TCP_SIZE 65535
+#define DNS_HEADER_SIZE 12
+#define DNS_TYPE_A 1
+#define DNS_TYPE_AAAA 28
+#define DNS_CLASS_IN 1
+#define DNS_RCODE_SERVFAIL 2
+#define DNS_RCODE_NXDOMAIN 3
+#define DNS_RECV_BATCH 16
+
+/* What one slot of a client's window holds */
+#define DNS_SLOT_FREE 0
+#define DNS_SLOT_UNSENT 1
+#define DNS_SLOT_WAITING 2
+#define DNS_SLOT_DONE 3
+
+/* Where one query in flight has got to.  Slot i of the
+ * window always uses socket i % DNS_SOCKETS */
+typedef struct DnsPending{
+    unsigned char packet[DNS_UDP_SIZE];
+    int length;
+    int type;
+    unsigned short id;
+    int state;
+    int attempts;
+    struct timespec deadline;
+    DnsQuery* query;
+} DnsPending;
+
+/* A client's window.  Free, unsent and done slots are
+ * kept in lists, and answers are found by their ID, so
+ * that moving the window along only touches the slots
+ * that changed.  The whole window is only scanned once
+ * nextDeadline, the earliest deadline of any waiting
+ * query (or earlier), has passed.  IDs are random, so
+ * that an answer can't be forged without seeing the
+ * query; they are drawn from the kernel a window's worth
+ * at a time */
+typedef struct DnsWindow{
+    DnsPending slots[DNS_WINDOW];
+    int freeList[DNS_WINDOW];
+    int numFree;
+    int unsentList[DNS_WINDOW];
+    int numUnsent;
+    int doneList[DNS_WINDOW];
+    int numDone;
+    int hasDeadline;
+    struct timespec nextDeadline;
+    unsigned short slotOfId[65536];
+    unsigned short randomIds[DNS_WINDOW];
+    int numRandomIds;
+} DnsWindow;
+
+int dns_parse_server(const char* spec, DnsServer* server){
+
+    char host[INET6_ADDRSTRLEN + 2];
+    const char* port = NULL;
+    const char* end = NULL;
+    int portNum = DNS_DEFAULT_PORT;
+    char extra;
+    struct sockaddr_in* v4 = (struct sockaddr_in*) &server->addr;
+    struct sockaddr_in6* v6 = (struct sockaddr_in6*) &server->addr;
+
+    /* Split off the port: [IPv6]:PORT, IPv4:PORT, or a
+     * bare IPv6 address, which has more than one colon */
+    if(spec[0] == '['){
+	end = strchr(spec, ']');
+	if(end == NULL || (end[1] != '\0' && end[1] != ':')){
+	    return UTIL_FAILURE;
+	}
+	port = end[1] == ':' ? end + 2 : NULL;
+	spec++;
+    }
+    else if(strchr(spec, ':') != NULL &&
+	    strchr(spec, ':') == strrchr(spec, ':')){
+	end = strchr(spec, ':');
+	port = end + 1;
+    }
+    else{
+	end = spec + strlen(spec);
+    }
+    if(end - spec <= 0 || end - spec >= (long) sizeof(host)){
+	return UTIL_FAILURE;
+    }
+    memcpy(host, spec, end - spec);
+    host[end - spec] = '\0';
+    if(port != NULL &&
+       (sscanf(port, "%d%c", &portNum, &extra) != 1 ||
+	portNum < 1 || portNum > 65535)){
+	return UTIL_FAILURE;
+    }
+
+    memset(server, 0, sizeof(*server));
+    if(inet_pton(AF_INET, host, &v4->sin_addr) == 1){
+	v4->sin_family = AF_INET;
+	v4->sin_port = htons(portNum);
+	server->len = sizeof(*v4);
+    }
+    else if(inet_pton(AF_INET6, host, &v6->sin6_addr) == 1){
+	v6->sin6_family = AF_INET6;
+	v6->sin6_port = htons(portNum);
+	server->len = sizeof(*v6);
+    }
+    else{
+	return UTIL_FAILURE;
+    }
+    return UTIL_SUCCESS;
+}
+
+int dnsclient_init(DnsClient* client, const DnsServer* server){
+
+    int i;
+
+    client->server = *server;
+    client->window = calloc(1, sizeof(DnsWindow));
+    if(client->window == NULL){
+	fprintf(stderr, "Error allocating DNS window\n");
+	return UTIL_FAILURE;
+    }
+    for(i = 0; i < DNS_WINDOW; i++){
+	client->window->freeList[i] = DNS_WINDOW - 1 - i;
+    }
+    client->window->numFree = DNS_WINDOW;
+    for(i = 0; i < DNS_SOCKETS; i++){
+	client->sockets[i] = socket(server->addr.ss_family,
+				    SOCK_DGRAM, 0);
+	/* Connected, so only the server's answers arrive */
+	if(client->sockets[i] < 0 ||
+	   connect(client->sockets[i],
+		   (struct sockaddr*) &server->addr,
+		   server->len) != 0){
+	    perror("Error opening DNS socket");
+	    while(i >= 0){
+		if(client->sockets[i] >= 0){
+		    close(client->sockets[i]);
+		}
+		i--;
+	    }
+	    free(client->window);
+	    return UTIL_FAILURE;
+	}
+    }
+    return UTIL_SUCCESS;
+}
+
+void dnsclient_close(DnsClient* client){
+
+    int i;
+
+    for(i = 0; i < DNS_SOCKETS; i++){
+	close(client->sockets[i]);
+    }
+    free(client->window);
+}
+
+/* Pick a random ID for pending that no other waiting
+ * query is using */
+static int dns_new_id(DnsWindow* window, DnsPending* pending){
+
+    DnsPending* other;
+    unsigned short id;
+
+    do{
+	if(window->numRandomIds == 0){
+	    if(getrandom(window->randomIds, sizeof(window->randomIds), 0)
+	       != (ssize_t) sizeof(window->randomIds)){
+		perror("Error drawing DNS query IDs");
+		return UTIL_FAILURE;
+	    }
+	    window->numRandomIds = DNS_WINDOW;
+	}
+	id = window->randomIds[--window->numRandomIds];
+	other = &window->slots[window->slotOfId[id]];
+    } while(other != pending && other->state == DNS_SLOT_WAITING &&
+	    other->id == id);
+
+    pending->id = id;
+    return UTIL_SUCCESS;
+}
+
+/* Build a query for hostname into pending, under a new ID */
+static int dns_build_query(DnsClient* client, DnsPending* pending,
+			   const char* hostname, int type){
+
+    unsigned char* p = pending->packet;
+    const char* label = hostname;
+    int off = DNS_HEADER_SIZE;
+
+    if(dns_new_id(client->window, pending) == UTIL_FAILURE){
+	return UTIL_FAILURE;
+    }
+    pending->type = type;
+    client->window->slotOfId[pending->id] = pending - client->window->slots;
+    memset(p, 0, DNS_HEADER_SIZE);
+    p[0] = pending->id >> 8;
+    p[1] = pending->id & 0xFF;
+    p[2] = 0x01; /* Recursion desired */
+    p[5] = 1;    /* One question */
+
+    /* Name as length-prefixed labels, at most 255 bytes */
+    while(*label != '\0'){
+	const char* dot = strchr(label, '.');
+	int len = dot != NULL ? dot - label : (int) strlen(label);
+	if(len == 0 || len > 63 ||
+	   off + len + 1 > DNS_HEADER_SIZE + 254){
+	    return UTIL_FAILURE;
+	}
+	p[off++] = len;
+	memcpy(p + off, label, len);
+	off += len;
+	label += len;
+	if(*label == '.'){
+	    label++;
+	}
+    }
+    if(off == DNS_HEADER_SIZE){
+	return UTIL_FAILURE;
+    }
+    p[off++] = 0;
+    p[off++] = 0;
+    p[off++] = type;
+    p[off++] = 0;
+    p[off++] = DNS_CLASS_IN;
+    pending->length = off;
+    return UTIL_SUCCESS;
+}
+
+/* Skip over a possibly compressed name, returning the
+ * offset just past it or -1 if it runs off the end */
+static int dns_skip_name(const unsigned char* buf, int len, int off){
+
+    while(off < len){
+	if(buf[off] == 0){
+	    return off + 1;
+	}
+	if((buf[off] & 0xC0) == 0xC0){
+	    return off + 2 <= len ? off + 2 : -1;
+	}
+	off += buf[off] + 1;
+    }
+    return -1;
+}
+
+/* Whether an answer is to the question pending asked */
+static int dns_matches(const DnsPending* pending,
+		       const unsigned char* buf, int len){
+
+    int i;
+
+    if(len < pending->length ||
+       buf[0] != pending->packet[0] || buf[1] != pending->packet[1] ||
+       (buf[2] & 0x80) == 0){
+	return 0;
+    }
+    /* Servers may echo the name in a different case */
+    for(i = DNS_HEADER_SIZE; i < pending->length; i++){
+	if(tolower(buf[i]) != tolower(pending->packet[i])){
+	    return 0;
+	}
+    }
+    return 1;
+}
+
+/* Find the first address of the asked type in an answer.
+ * Returns UTIL_SUCCESS, UTIL_FAILURE, UTIL_TRYAGAIN, or 1
+ * if the name exists but has no address of that type */
+static int dns_parse_answer(const DnsPending* pending,
+			    const unsigned char* buf, int len,
+			    char* firstIPstr, int maxSize){
+
+    int rcode = buf[3] & 0x0F;
+    int qdcount = (buf[4] << 8) | buf[5];
+    int ancount = (buf[6] << 8) | buf[7];
+    int off = DNS_HEADER_SIZE;
+    char ipstr[INET6_ADDRSTRLEN];
+
+    if(rcode == DNS_RCODE_SERVFAIL){
+	return UTIL_TRYAGAIN;
+    }
+    if(rcode != 0){
+	return UTIL_FAILURE;
+    }
+    while(qdcount-- > 0 && off >= 0){
+	off = dns_skip_name(buf, len, off);
+	off = off >= 0 ? off + 4 : -1;
+    }
+    /* Answers may lead with CNAMEs; take the first address */
+    while(ancount-- > 0 && off >= 0){
+	int type, class, rdlength;
+	off = dns_skip_name(buf, len, off);
+	if(off < 0 || off + 10 > len){
+	    return UTIL_FAILURE;
+	}
+	type = (buf[off] << 8) | buf[off + 1];
+	class = (buf[off + 2] << 8) | buf[off + 3];
+	rdlength = (buf[off + 8] << 8) | buf[off + 9];
+	off += 10;
+	if(off + rdlength > len){
+	    return UTIL_FAILURE;
+	}
+	if(type == pending->type && class == DNS_CLASS_IN &&
+	   rdlength == (type == DNS_TYPE_A ? 4 : 16)){
+	    if(!inet_ntop(type == DNS_TYPE_A ? AF_INET : AF_INET6,
+			  buf + off, ipstr, sizeof(ipstr))){
+		perror("Error Converting IP to String");
+		return UTIL_FAILURE;
+	    }
+	    strncpy(firstIPstr, ipstr, maxSize);
+	    firstIPstr[maxSize-1] = '\0';
+	    return UTIL_SUCCESS;
+	}
+	off += rdlength;
+    }
+    return off >= 0 ? 1 : UTIL_FAILURE;
+}
+
+/* Read or write exactly len bytes of a TCP stream */
+static int dns_tcp_io(int fd, unsigned char* buf, int len, int writing){
+
+    int done = 0;
+    while(done < len){
+	ssize_t n = writing ? write(fd, buf + done, len - done)
+			    : read(fd, buf + done, len - done);
+	if(n <= 0){
+	    return UTIL_FAILURE;
+	}
+	done += n;
+    }
+    return UTIL_SUCCESS;
+}
+
+/* Ask a truncated query again over TCP.  Returns the
+ * length of the answer, or -1 */
+static int dns_tcp_query(DnsClient* client, const DnsPending* pending,
+			 unsigned char* answer){
+
+    struct timeval timeout = {DNS_TIMEOUT_MS / 1000,
+			      (DNS_TIMEOUT_MS % 1000) * 1000};
+    unsigned char prefix[2];
+    int len = -1;
+    int fd = socket(client->server.addr.ss_family, SOCK_STREAM, 0);
+
+    if(fd < 0){
+	return -1;
+    }
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    /* Over TCP, each message is prefixed with its length */
+    prefix[0] = pending->length >> 8;
+    prefix[1] = pending->length & 0xFF;
+    if(connect(fd, (struct sockaddr*) &client->server.addr,
+	       client->server.len) == 0 &&
+       dns_tcp_io(fd, prefix, 2, 1) == UTIL_SUCCESS &&
+       dns_tcp_io(fd, (unsigned char*) pending->packet,
+		  pending->length, 1) == UTIL_SUCCESS &&
+       dns_tcp_io(fd, prefix, 2, 0) == UTIL_SUCCESS){
+	len = (prefix[0] << 8) | prefix[1];
+	if(len < DNS_HEADER_SIZE ||
+	   dns_tcp_io(fd, answer, len, 0) != UTIL_SUCCESS){
+	    len = -1;
+	}
+    }
+    close(fd);
+    return len;
+}
+
+/* Milliseconds from now until a deadline, at least 0 */
+static long dns_ms_until(const struct timespec* deadline,
+			 const struct timespec* now){
+
+    long ms = (deadline->tv_sec - now->tv_sec) * 1000 +
+	(deadline->tv_nsec - now->tv_nsec) / 1000000;
+    return ms > 0 ? ms : 0;
+}
+
+/* Put a slot on the unsent or done list */
+static void dns_mark(DnsWindow* window, DnsPending* pending, int state){
+
+    int slot = pending - window->slots;
+
+    pending->state = state;
+    if(state == DNS_SLOT_UNSENT){
+	window->unsentList[window->numUnsent++] = slot;
+    }
+    else{
+	window->doneList[window->numDone++] = slot;
+    }
+}
+
+/* Send every unsent query, batched per socket, and give
+ * each its own deadline */
+static void dns_send_unsent(DnsClient* client){
+
+    DnsWindow* window = client->window;
+    struct mmsghdr msgs[DNS_WINDOW];
+    struct iovec iovs[DNS_WINDOW];
+    struct timespec deadline;
+    int s, i, n, sent;
+
+    if(window->numUnsent == 0){
+	return;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += DNS_TIMEOUT_MS / 1000;
+    deadline.tv_nsec += (DNS_TIMEOUT_MS % 1000) * 1000000L;
+    if(deadline.tv_nsec >= 1000000000L){
+	deadline.tv_sec++;
+	deadline.tv_nsec -= 1000000000L;
+    }
+    /* Every query sent now is due after those sent before,
+     * so this only moves nextDeadline if none are waiting */
+    if(!window->hasDeadline){
+	window->hasDeadline = 1;
+	window->nextDeadline = deadline;
+    }
+
+    for(s = 0; s < DNS_SOCKETS; s++){
+	n = 0;
+	for(i = 0; i < window->numUnsent; i++){
+	    DnsPending* pending = &window->slots[window->unsentList[i]];
+	    if(window->unsentList[i] % DNS_SOCKETS != s){
+		continue;
+	    }
+	    pending->state = DNS_SLOT_WAITING;
+	    pending->deadline = deadline;
+	    iovs[n].iov_base = pending->packet;
+	    iovs[n].iov_len = pending->length;
+	    memset(&msgs[n], 0, sizeof(msgs[n]));
+	    msgs[n].msg_hdr.msg_iov = &iovs[n];
+	    msgs[n].msg_hdr.msg_iovlen = 1;
+	    n++;
+	}
+	/* A send that fails is simply retried after the timeout */
+	for(sent = 0; sent < n; ){
+	    int r = sendmmsg(client->sockets[s], msgs + sent, n - sent, 0);
+	    if(r <= 0){
+		break;
+	    }
+	    sent += r;
+	}
+    }
+    window->numUnsent = 0;
+}
+
+/* Settle one answer: the query is either done, or asked
+ * again as an AAAA query */
+static void dns_settle(DnsClient* client, DnsPending* pending,
+		       const unsigned char* buf, int len){
+
+    static __thread unsigned char tcpAnswer[DNS_TCP_SIZE];
+    DnsQuery* query = pending->query;
+    int result;
+
+    /* Truncated: the whole answer only fits over TCP */
+    if(buf[2] & 0x02){
+	len = dns_tcp_query(client, pending, tcpAnswer);
+	if(len < 0 || !dns_matches(pending, tcpAnswer, len)){
+	    query->result = UTIL_TRYAGAIN;
+	    dns_mark(client->window, pending, DNS_SLOT_DONE);
+	    return;
+	}
+	buf = tcpAnswer;
+    }
+
+    result = dns_parse_answer(pending, buf, len,
+			      query->firstIPstr, query->maxSize);
+    if(result == 1 && pending->type == DNS_TYPE_A &&
+       dns_build_query(client, pending, query->hostname,
+		       DNS_TYPE_AAAA) == UTIL_SUCCESS){
+	pending->attempts = 0;
+	dns_mark(client->window, pending, DNS_SLOT_UNSENT);
+	return;
+    }
+    query->result = result == 1 ? UTIL_FAILURE : result;
+    dns_mark(client->window, pending, DNS_SLOT_DONE);
+}
+
+/* Read every answer waiting on one socket */
+static void dns_receive(DnsClient* client, int s){
+
+    struct mmsghdr msgs[DNS_RECV_BATCH];
+    struct iovec iovs[DNS_RECV_BATCH];
+    unsigned char answers[DNS_RECV_BATCH][DNS_UDP_SIZE];
+    int j, n;
+
+    do{
+	for(j = 0; j < DNS_RECV_BATCH; j++){
+	    iovs[j].iov_base = answers[j];
+	    iovs[j].iov_len = DNS_UDP_SIZE;
+	    memset(&msgs[j], 0, sizeof(msgs[j]));
+	    msgs[j].msg_hdr.msg_iov = &iovs[j];
+	    msgs[j].msg_hdr.msg_iovlen = 1;
+	}
+	n = recvmmsg(client->sockets[s], msgs, DNS_RECV_BATCH,
+		     MSG_DONTWAIT, NULL);
+	for(j = 0; j < n; j++){
+	    int len = msgs[j].msg_len;
+	    DnsPending* pending;
+	    if(len < DNS_HEADER_SIZE){
+		continue;
+	    }
+	    /* Anything that matches no waiting query is a
+	     * late answer to an earlier attempt */
+	    pending = &client->window->slots[
+		client->window->slotOfId[(answers[j][0] << 8) | answers[j][1]]];
+	    if(pending->state == DNS_SLOT_WAITING &&
+	       dns_matches(pending, answers[j], len)){
+		dns_settle(client, pending, answers[j], len);
+	    }
+	}
+    } while(n == DNS_RECV_BATCH);
+}
+
+/* Send again, or give up on, every query past its
+ * deadline, and work out the next deadline */
+static void dns_expire(DnsWindow* window, const struct timespec* now){
+
+    int i;
+
+    window->hasDeadline = 0;
+    for(i = 0; i < DNS_WINDOW; i++){
+	DnsPending* pending = &window->slots[i];
+	if(pending->state != DNS_SLOT_WAITING){
+	    continue;
+	}
+	if(dns_ms_until(&pending->deadline, now) > 0){
+	    if(!window->hasDeadline ||
+	       pending->deadline.tv_sec < window->nextDeadline.tv_sec ||
+	       (pending->deadline.tv_sec == window->nextDeadline.tv_sec &&
+		pending->deadline.tv_nsec < window->nextDeadline.tv_nsec)){
+		window->hasDeadline = 1;
+		window->nextDeadline = pending->deadline;
+	    }
+	}
+	/* Sent again with the same ID, so a late answer to
+	 * an earlier attempt still counts */
+	else if(pending->attempts < DNS_RETRIES){
+	    pending->attempts++;
+	    dns_mark(window, pending, DNS_SLOT_UNSENT);
+	}
+	else{
+	    pending->query->result = UTIL_TRYAGAIN;
+	    dns_mark(window, pending, DNS_SLOT_DONE);
+	}
+    }
+}
+
+int dnsclient_submit(DnsClient* client, DnsQuery* query){
+
+    DnsWindow* window = client->window;
+    unsigned char literal[sizeof(struct in6_addr)];
+    DnsPending* pending;
+
+    if(window->numFree == 0){
+	return UTIL_FAILURE;
+    }
+    pending = &window->slots[window->freeList[--window->numFree]];
+    pending->query = query;
+    pending->attempts = 0;
+    query->result = UTIL_TRYAGAIN;
+
+    /* Like getaddrinfo, an address resolves to itself */
+    if(inet_pton(AF_INET, query->hostname, literal) == 1 ||
+       inet_pton(AF_INET6, query->hostname, literal) == 1){
+	strncpy(query->firstIPstr, query->hostname, query->maxSize);
+	query->firstIPstr[query->maxSize-1] = '\0';
+	query->result = UTIL_SUCCESS;
+	dns_mark(window, pending, DNS_SLOT_DONE);
+    }
+    else if(dns_build_query(client, pending, query->hostname,
+			    DNS_TYPE_A) != UTIL_SUCCESS){
+	query->result = UTIL_FAILURE;
+	dns_mark(window, pending, DNS_SLOT_DONE);
+    }
+    else{
+	dns_mark(window, pending, DNS_SLOT_UNSENT);
+    }
+    return UTIL_SUCCESS;
+}
+
+int dnsclient_poll(DnsClient* client, DnsQuery** done, int timeoutMs){
+
+    DnsWindow* window = client->window;
+    struct pollfd fds[DNS_SOCKETS];
+    struct timespec now;
+    long wait = timeoutMs;
+    int count = 0;
+    int i, s;
+
+    dns_send_unsent(client);
+
+    /* Wait no longer than the earliest deadline, and not
+     * at all if a query is already done */
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if(window->numDone > 0){
+	wait = 0;
+    }
+    else if(window->hasDeadline &&
+	    dns_ms_until(&window->nextDeadline, &now) < wait){
+	wait = dns_ms_until(&window->nextDeadline, &now);
+    }
+    for(s = 0; s < DNS_SOCKETS; s++){
+	fds[s].fd = client->sockets[s];
+	fds[s].events = POLLIN;
+	fds[s].revents = 0;
+    }
+    if(poll(fds, DNS_SOCKETS, wait) > 0){
+	for(s = 0; s < DNS_SOCKETS; s++){
+	    if(fds[s].revents & POLLIN){
+		dns_receive(client, s);
+	    }
+	}
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if(window->hasDeadline &&
+       dns_ms_until(&window->nextDeadline, &now) == 0){
+	dns_expire(window, &now);
+    }
+    dns_send_unsent(client);
+
+    /* Hand back everything that is done, freeing its slot */
+    for(i = 0; i < window->numDone; i++){
+	DnsPending* pending = &window->slots[window->doneList[i]];
+	if(pending->query->result != UTIL_SUCCESS){
+	    fprintf(stderr, "Error looking up Address: %s\n",
+		    pending->query->result == UTIL_TRYAGAIN ?
+		    "Temporary failure in name resolution" :
+		    "Name or service not known");
+	}
+	done[count++] = pending->query;
+	pending->state = DNS_SLOT_FREE;
+	window->freeList[window->numFree++] = window->doneList[i];
+    }
+    window->numDone = 0;
+    return count;
+}
@@ -27,16 +27,91 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netdb.h>
+#include <netinet/in.h>
 
 #define UTIL_FAILURE -1
 #define UTIL_SUCCESS 0
+#define UTIL_TRYAGAIN -2
 
 /* Fuction to return the first IP address found
  * for hostname. IP address returned as string
- * firstIPstr of size maxsize
+ * firstIPstr of size maxsize.  Returns UTIL_TRYAGAIN
+ * instead of UTIL_FAILURE when the lookup failed
+ * temporarily (timeout or SERVFAIL upstream)
  */
 int dnslookup(const char* hostname,
 	      char* firstIPstr,
 	      int maxSize);
 
+/* Limits of the native client.  Up to DNS_WINDOW queries
+ * are in flight at once, spread over DNS_SOCKETS UDP
+ * sockets.  A query still unanswered after DNS_TIMEOUT_MS
+ * is sent again, up to DNS_RETRIES more times */
+#define DNS_WINDOW 256
+#define DNS_SOCKETS 4
+#define DNS_TIMEOUT_MS 1000
+#define DNS_RETRIES 2
+#define DNS_DEFAULT_PORT 53
+
+/* Address of the upstream DNS server the native client
+ * sends its queries to */
+typedef struct DnsServer{
+    struct sockaddr_storage addr;
+    socklen_t len;
+} DnsServer;
+
+/* One client per thread: its sockets and its window of
+ * queries in flight are never shared */
+typedef struct DnsClient{
+    DnsServer server;
+    int sockets[DNS_SOCKETS];
+    struct DnsWindow* window;
+} DnsClient;
+
+/* One hostname to look up.  result is set to what
+ * dnslookup would have returned for it, and on success
+ * the address is written to firstIPstr */
+typedef struct DnsQuery{
+    const char* hostname;
+    char* firstIPstr;
+    int maxSize;
+    int result;
+} DnsQuery;
+
+/* Function to parse a server address of the form IP,
+ * IP:PORT, IPv6 or [IPv6]:PORT.  Returns UTIL_FAILURE
+ * if it isn't one */
+int dns_parse_server(const char* spec, DnsServer* server);
+
+/* Function to open the UDP sockets of a native client
+ * for the given server, and allocate its window */
+int dnsclient_init(DnsClient* client, const DnsServer* server);
+
+/* Function to add a query to the native client's window,
+ * without getaddrinfo.  The hostname is asked as an A
+ * query (then an AAAA query if it has no IPv4 address).
+ * It is only sent by the next dnsclient_poll, so queries
+ * submitted together go out with one sendmmsg per
+ * socket.  The query must stay in place until it comes
+ * back from dnsclient_poll.  Returns UTIL_FAILURE if the
+ * window is full */
+int dnsclient_submit(DnsClient* client, DnsQuery* query);
+
+/* Function to move the native client's window along.
+ * Unsent queries are sent, then it waits up to timeoutMs
+ * (or until the earliest deadline) for answers, which
+ * are collected with recvmmsg and matched to their
+ * queries by ID and question.  A truncated answer is
+ * asked again over TCP.  Each query past its deadline is
+ * sent again on its own, without holding up the rest.
+ * Every query answered or out of retries is stored in
+ * done, which must have room for DNS_WINDOW.  Returns
+ * how many were stored */
+int dnsclient_poll(DnsClient* client,
+		   DnsQuery** done,
+		   int timeoutMs);
+
+/* Function to close a native client's sockets */
+void dnsclient_close(DnsClient* client);
+
 #endif